@@ -17,16 +17,44 @@ set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
 #                     SOURCES source1_file [source2_file ...]
 #                     [EXTRA_SOURCES source1_file ...]
 #                     [GENERATED_SOURCES_VAR]       # Output variable containing list of generated binding source files
-#                     [DEBUG] [EXCLUDE_FROM_ALL]
+#                     [UNITY_FILES count]           # Merge binding sources into `count` translation units
+#                     [SPLIT_CLASS_THRESHOLD count] # Split classes with more method overloads than `count`
+#                     [OUTPUT_LAYOUT layout]        # `flat` (default), `hash` or `namespace` subdirectories
+#                     [DEBUG] [EXCLUDE_FROM_ALL] [MINIMAL_INCLUDES]
+#                     [PRECOMPILE_HEADER]           # Precompile a generated prefix header (CMake 3.16+)
+#                     [LIST_OUTPUTS]                # List generated files at configure time (see below)
+#                     [PCH_INCLUDES header1 ...]    # Parse heavy headers through a cached precompiled header
+#                     [AST_CACHE]                   # Load the parsed sources from a cache when unchanged
+#                     [SERVER]                      # Let a chimera server generate the bindings (see below)
+#                     [SHARDS count]                # Render the bindings in `count` parallel commands
+#
+# With LIST_OUTPUTS, the generated files are listed by a dry run of chimera at
+# configure time and declared as outputs of the generation step, so that the
+# generation and compilation of the bindings are scheduled in a single build.
+# This requires `chimera_EXECUTABLE` to be an existing file and the compilation
+# database to exist, so the first configuration falls back to the default.
+# A change to any header can add or remove outputs, so every generation checks
+# the files it lists against the ones listed at configure time.  If they
+# differ, the build fails and the next build reconfigures with the new list.
+#
+# With SERVER, building the `<target>_SERVE` target starts a chimera server
+# that keeps the sources parsed.  While it runs, the bindings are generated by
+# the server, which only reparses what changed.  The server listens on a socket
+# in `$XDG_RUNTIME_DIR` or `/tmp`, which is named after a hash of the target.
+#
+# With SHARDS, each shard of the bindings is rendered by a command of its own,
+# which the build can run in parallel, and a final merge lists all of them.
+# Every shard parses the sources, so this works best with AST_CACHE or
+# PCH_INCLUDES.  Sharded bindings are not generated by the server.
 function(add_chimera_binding)
     include(ExternalProject)
 
     # Parse boolean, unary, and list arguments from input.
     # Unparsed arguments can be found in variable ARG_UNPARSED_ARGUMENTS.
     set(prefix binding)
-    set(options DEBUG EXCLUDE_FROM_ALL)
-    set(oneValueArgs TARGET MODULE CONFIGURATION DESTINATION BINDING GENERATED_SOURCES_VAR)
-    set(multiValueArgs SOURCES NAMESPACES EXTRA_SOURCES LINK_LIBRARIES)
+    set(options DEBUG EXCLUDE_FROM_ALL MINIMAL_INCLUDES PRECOMPILE_HEADER LIST_OUTPUTS AST_CACHE SERVER)
+    set(oneValueArgs TARGET MODULE CONFIGURATION DESTINATION BINDING GENERATED_SOURCES_VAR UNITY_FILES SPLIT_CLASS_THRESHOLD OUTPUT_LAYOUT SHARDS)
+    set(multiValueArgs SOURCES NAMESPACES EXTRA_SOURCES LINK_LIBRARIES PCH_INCLUDES)
     cmake_parse_arguments("${prefix}" "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
 
     # Print errors if arguments are missing.
@@ -64,6 +92,15 @@ function(add_chimera_binding)
         if(binding_CONFIGURATION)
             message(STATUS "  Configuration: ${binding_CONFIGURATION}")
         endif()
+        if(binding_UNITY_FILES)
+            message(STATUS "  Unity files: ${binding_UNITY_FILES}")
+        endif()
+        if(binding_SPLIT_CLASS_THRESHOLD)
+            message(STATUS "  Split class threshold: ${binding_SPLIT_CLASS_THRESHOLD}")
+        endif()
+        if(binding_SHARDS)
+            message(STATUS "  Shards: ${binding_SHARDS}")
+        endif()
         if(binding_NAMESPACES)
             message(STATUS "  Namespaces:")
             foreach(namespace ${binding_NAMESPACES})
@@ -88,6 +125,8 @@ function(add_chimera_binding)
     file(MAKE_DIRECTORY "${binding_DESTINATION}")
     set(binding_SOURCES_TXT "${binding_DESTINATION}/sources.txt")
     set(binding_EMPTY_CPP "${binding_DESTINATION}/empty.cpp")
+    set(binding_LISTED_TXT "${binding_DESTINATION}/sources.listed")
+    set(binding_CHECK_OUTPUTS "${binding_DESTINATION}/check_outputs.cmake")
     file(WRITE "${binding_EMPTY_CPP}"
       "/// ==================================================================\n"
       "/// AUTOGENERATED BY CHIMERA - DO NOT EDIT\n"
@@ -108,13 +147,178 @@ function(add_chimera_binding)
     if(binding_CONFIGURATION)
         list(APPEND binding_ARGS -c "${binding_CONFIGURATION}")
     endif()
+    if(binding_MINIMAL_INCLUDES)
+        list(APPEND binding_ARGS -minimal-includes)
+    endif()
+    if(binding_PRECOMPILE_HEADER)
+        list(APPEND binding_ARGS -prefix-header)
+    endif()
+    if(binding_UNITY_FILES)
+        list(APPEND binding_ARGS "-unity-files=${binding_UNITY_FILES}")
+    endif()
+    if(binding_OUTPUT_LAYOUT)
+        list(APPEND binding_ARGS "-output-layout=${binding_OUTPUT_LAYOUT}")
+    endif()
+    if(binding_SPLIT_CLASS_THRESHOLD)
+        list(APPEND binding_ARGS "-split-class-threshold=${binding_SPLIT_CLASS_THRESHOLD}")
+    endif()
+    if(binding_AST_CACHE)
+        list(APPEND binding_ARGS "-ast-cache=${CMAKE_CURRENT_BINARY_DIR}/${binding_TARGET}_ast")
+    endif()
+    if(binding_PCH_INCLUDES)
+        list(APPEND binding_ARGS "-pch-cache=${CMAKE_CURRENT_BINARY_DIR}/${binding_TARGET}_pch")
+        foreach(header ${binding_PCH_INCLUDES})
+            list(APPEND binding_ARGS "-pch-include=${header}")
+        endforeach()
+    endif()
     if(binding_NAMESPACES)
         foreach(namespace ${binding_NAMESPACES})
             list(APPEND binding_ARGS -n "${namespace}")
         endforeach()
     endif()
     list(APPEND binding_ARGS ${binding_SOURCES})
-    list(APPEND binding_ARGS > "${binding_SOURCES_TXT}.staging")
+
+    # List the generated files with a dry run if requested and possible.
+    set(binding_OUTPUTS_LISTED FALSE)
+    if(binding_LIST_OUTPUTS)
+        # (Byproducts of custom commands require CMake 3.2 or newer.)
+        if(NOT CMAKE_VERSION VERSION_LESS 3.2
+           AND EXISTS "${chimera_EXECUTABLE}"
+           AND EXISTS "${PROJECT_BINARY_DIR}/compile_commands.json")
+            execute_process(
+                COMMAND "${chimera_EXECUTABLE}" ${binding_ARGS} -list-outputs
+                WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+                RESULT_VARIABLE binding_LIST_RESULT
+                OUTPUT_VARIABLE binding_LIST_OUTPUT
+                OUTPUT_STRIP_TRAILING_WHITESPACE
+            )
+            if(binding_LIST_RESULT EQUAL 0)
+                string(REPLACE "\n" ";" binding_GENERATED_RELATIVE "${binding_LIST_OUTPUT}")
+                set(binding_OUTPUTS_LISTED TRUE)
+                file(WRITE "${binding_LISTED_TXT}" "${binding_LIST_OUTPUT}\n")
+            else()
+                message(WARNING "Chimera binding '${binding_TARGET}' could not list its outputs.")
+            endif()
+        endif()
+
+        # Added or removed declarations change the outputs, so reconfigure
+        # whenever the inputs change, or when a generation found that the
+        # outputs changed along with a header that the sources include.
+        set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS
+            ${binding_CONFIGURATION} ${binding_SOURCES}
+        )
+        if(binding_OUTPUTS_LISTED)
+            set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS
+                "${binding_LISTED_TXT}"
+            )
+        endif()
+    elseif(EXISTS "${binding_SOURCES_TXT}")
+        # Get the current list of generated sources if already generated.
+        file(STRINGS "${binding_SOURCES_TXT}" binding_GENERATED_RELATIVE NO_HEX_CONVERSION)
+    endif()
+
+    set(binding_GENERATED)
+    foreach(relative_path ${binding_GENERATED_RELATIVE})
+        list(APPEND binding_GENERATED "${binding_DESTINATION}/${relative_path}")
+    endforeach()
+
+    # Declare listed files as byproducts, so that files which chimera leaves
+    # unchanged are not recompiled.  Since the list is only updated when the
+    # project is configured, compare it with the outputs of each generation.
+    # A mismatch touches the list, which makes the next build reconfigure.
+    set(binding_BYPRODUCTS)
+    set(binding_CHECK_COMMAND)
+    if(binding_OUTPUTS_LISTED)
+        set(binding_BYPRODUCTS BYPRODUCTS ${binding_GENERATED})
+        file(WRITE "${binding_CHECK_OUTPUTS}"
+          "file(STRINGS \"\${LISTED}\" listed)\n"
+          "file(STRINGS \"\${GENERATED}\" generated)\n"
+          "list(SORT listed)\n"
+          "list(SORT generated)\n"
+          "if(NOT \"\${listed}\" STREQUAL \"\${generated}\")\n"
+          "  execute_process(COMMAND \"\${CMAKE_COMMAND}\" -E touch \"\${LISTED}\")\n"
+          "  message(FATAL_ERROR \"The files generated for \${TARGET} changed \"\n"
+          "    \"since the project was configured. Build again to reconfigure.\")\n"
+          "endif()\n"
+        )
+        set(binding_CHECK_COMMAND
+            COMMAND ${CMAKE_COMMAND}
+                "-DLISTED=${binding_LISTED_TXT}"
+                "-DGENERATED=${binding_SOURCES_TXT}"
+                "-DTARGET=${binding_TARGET}"
+                -P "${binding_CHECK_OUTPUTS}"
+        )
+    endif()
+
+    # Let chimera report every header and snippet that the bindings depend on,
+    # where custom commands support depfiles (Ninja, or CMake 3.20 or newer).
+    set(binding_DEPFILE)
+    set(binding_SHARD_ARGS ${binding_ARGS})
+    set(binding_USE_DEPFILE FALSE)
+    if(CMAKE_GENERATOR MATCHES "Ninja" OR NOT CMAKE_VERSION VERSION_LESS 3.20)
+        set(binding_USE_DEPFILE TRUE)
+        set(binding_DEPFILE_PATH "${binding_DESTINATION}/sources.d")
+        file(RELATIVE_PATH binding_DEPFILE_TARGET "${CMAKE_BINARY_DIR}" "${binding_SOURCES_TXT}")
+        list(APPEND binding_ARGS
+            "-depfile=${binding_DEPFILE_PATH}"
+            "-depfile-target=${binding_DEPFILE_TARGET}"
+        )
+        set(binding_DEPFILE DEPFILE "${binding_DEPFILE_PATH}")
+    endif()
+
+    # If requested, let a running server generate the bindings if there is
+    # one.  Socket paths are limited to about a hundred characters, so the
+    # socket is named after a hash of the target rather than placed in the
+    # binary directory.
+    set(binding_GENERATE_ARGS ${binding_ARGS})
+    if(binding_SERVER)
+        set(binding_SOCKET_DIR "$ENV{XDG_RUNTIME_DIR}")
+        if(NOT binding_SOCKET_DIR)
+            set(binding_SOCKET_DIR "/tmp")
+        endif()
+        string(MD5 binding_SOCKET_HASH "${CMAKE_CURRENT_BINARY_DIR}/${binding_TARGET}")
+        string(SUBSTRING "${binding_SOCKET_HASH}" 0 16 binding_SOCKET_HASH)
+        set(binding_SOCKET "${binding_SOCKET_DIR}/chimera-${binding_SOCKET_HASH}.sock")
+        add_custom_target("${binding_TARGET}_SERVE"
+            COMMAND "${chimera_EXECUTABLE}" ${binding_ARGS} "-serve=${binding_SOCKET}"
+            WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+            COMMENT "Serving bindings for ${binding_TARGET} on ${binding_SOCKET}."
+            VERBATIM
+        )
+        list(APPEND binding_GENERATE_ARGS "-connect=${binding_SOCKET}")
+    endif()
+
+    # With SHARDS, each shard is rendered by a command of its own, which
+    # records what it rendered in a listing that the merge combines into the
+    # generated files.
+    set(binding_GENERATE_DEPENDS "${binding_CONFIGURATION}" ${binding_SOURCES})
+    if(binding_SHARDS)
+        math(EXPR binding_LAST_SHARD "${binding_SHARDS} - 1")
+        foreach(shard RANGE ${binding_LAST_SHARD})
+            set(binding_SHARD_LISTING "${binding_DESTINATION}/${binding_MODULE}.shard-${shard}-of-${binding_SHARDS}")
+            set(binding_SHARD_DEPFILE)
+            set(binding_SHARD_DEPFILE_ARGS)
+            if(binding_USE_DEPFILE)
+                file(RELATIVE_PATH binding_SHARD_TARGET "${CMAKE_BINARY_DIR}" "${binding_SHARD_LISTING}")
+                set(binding_SHARD_DEPFILE DEPFILE "${binding_SHARD_LISTING}.d")
+                set(binding_SHARD_DEPFILE_ARGS
+                    "-depfile=${binding_SHARD_LISTING}.d"
+                    "-depfile-target=${binding_SHARD_TARGET}"
+                )
+            endif()
+            add_custom_command(
+                OUTPUT "${binding_SHARD_LISTING}"
+                COMMAND "${chimera_EXECUTABLE}" ARGS ${binding_SHARD_ARGS} ${binding_SHARD_DEPFILE_ARGS} "-shard=${shard}/${binding_SHARDS}"
+                DEPENDS "${binding_CONFIGURATION}" ${binding_SOURCES}
+                WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+                ${binding_SHARD_DEPFILE}
+                COMMENT "Generating shard ${shard} of bindings for ${binding_TARGET}."
+                VERBATIM
+            )
+            list(APPEND binding_GENERATE_DEPENDS "${binding_SHARD_LISTING}")
+        endforeach()
+        set(binding_GENERATE_ARGS ${binding_ARGS} "-merge-shards=${binding_SHARDS}")
+    endif()
 
     # Create an external target that re-runs chimera when any of the sources have changed.
     # This will necessarily invalidate a placeholder dependency that causes CMake to
@@ -122,24 +326,17 @@ function(add_chimera_binding)
     add_custom_target("${binding_TARGET}_SOURCES" DEPENDS "${binding_SOURCES_TXT}")
     add_custom_command(
         OUTPUT "${binding_SOURCES_TXT}"
-        COMMAND "${chimera_EXECUTABLE}" ARGS ${binding_ARGS}
+        ${binding_BYPRODUCTS}
+        COMMAND "${chimera_EXECUTABLE}" ARGS ${binding_GENERATE_ARGS} > "${binding_SOURCES_TXT}.staging"
         COMMAND ${CMAKE_COMMAND} ARGS -E rename "${binding_SOURCES_TXT}.staging" "${binding_SOURCES_TXT}"
-        DEPENDS "${binding_CONFIGURATION}" ${binding_SOURCES}
+        ${binding_CHECK_COMMAND}
+        DEPENDS ${binding_GENERATE_DEPENDS}
         WORKING_DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}"
+        ${binding_DEPFILE}
         COMMENT "Generating bindings for ${binding_TARGET}."
         VERBATIM
     )
 
-    # Get the current list of generated sources if already generated.
-    if(EXISTS "${binding_SOURCES_TXT}")
-        file(STRINGS "${binding_SOURCES_TXT}" binding_GENERATED_RELATIVE NO_HEX_CONVERSION)
-
-        set(binding_GENERATED)
-        foreach(relative_path ${binding_GENERATED_RELATIVE})
-            list(APPEND binding_GENERATED "${binding_DESTINATION}/${relative_path}")
-        endforeach()
-    endif()
-
     # Placeholder target to generate compilation database.
     #
     # (We force all SOURCES to be treated as CXX so that we can generate bindings
@@ -174,21 +371,44 @@ function(add_chimera_binding)
         ${binding_EXTRA_SOURCES}
     )
 
+    # Bindings include each other's headers by their path in the output
+    # directory, which has subdirectories in some output layouts.
+    target_include_directories("${binding_TARGET}" PRIVATE "${binding_DESTINATION}")
+
+    # Precompile the prefix header that chimera generates alongside the module.
+    if(binding_PRECOMPILE_HEADER)
+        if(COMMAND target_precompile_headers)
+            set(binding_PREFIX_H "${binding_DESTINATION}/${binding_MODULE}_prefix.h")
+            set_source_files_properties("${binding_PREFIX_H}" PROPERTIES GENERATED TRUE)
+            target_precompile_headers("${binding_TARGET}" PRIVATE "${binding_PREFIX_H}")
+        else()
+            message(WARNING "Chimera binding '${binding_TARGET}' requests a "
+                "precompiled header, which requires CMake 3.16 or newer.")
+        endif()
+    endif()
+
     # Trigger the rebuild of the library target after new sources have been generated.
     #
     # For BUILD_COMMAND, '$(MAKE)' is used instead of 'make' to propagate the
     # make commands of the parent project to the child process.
     # (see: http://stackoverflow.com/a/33171336)
-    ExternalProject_Add("${binding_TARGET}_REBUILD"
-        DOWNLOAD_COMMAND ""
-        INSTALL_COMMAND ""
-        BUILD_COMMAND $(MAKE) "${binding_TARGET}_SOURCES"
-        DEPENDS "${binding_TARGET}_SOURCES"
-        SOURCE_DIR "${PROJECT_SOURCE_DIR}"
-        BINARY_DIR "${PROJECT_BINARY_DIR}"
-    )
-    set_target_properties("${binding_TARGET}_REBUILD" PROPERTIES EXCLUDE_FROM_ALL TRUE)
-    add_dependencies("${binding_TARGET}" "${binding_TARGET}_REBUILD")
+    #
+    # When the outputs were listed up front, the generation step is an ordinary
+    # dependency of the library instead.
+    if(binding_OUTPUTS_LISTED)
+        add_dependencies("${binding_TARGET}" "${binding_TARGET}_SOURCES")
+    else()
+        ExternalProject_Add("${binding_TARGET}_REBUILD"
+            DOWNLOAD_COMMAND ""
+            INSTALL_COMMAND ""
+            BUILD_COMMAND $(MAKE) "${binding_TARGET}_SOURCES"
+            DEPENDS "${binding_TARGET}_SOURCES"
+            SOURCE_DIR "${PROJECT_SOURCE_DIR}"
+            BINARY_DIR "${PROJECT_BINARY_DIR}"
+        )
+        set_target_properties("${binding_TARGET}_REBUILD" PROPERTIES EXCLUDE_FROM_ALL TRUE)
+        add_dependencies("${binding_TARGET}" "${binding_TARGET}_REBUILD")
+    endif()
 
     # Set ${binding_GENERATED_SOURCES_VAR} with the list of generated bindings
     if(binding_GENERATED_SOURCES_VAR)
@@ -8,6 +8,7 @@
 # Load variables which will be used in binding template.
 file(READ "${BINDING_PATH}/class.h.tmpl" BINDING_CLASS_H)
 file(READ "${BINDING_PATH}/class.cpp.tmpl" BINDING_CLASS_CPP)
+file(READ "${BINDING_PATH}/class_part.cpp.tmpl" BINDING_CLASS_PART_CPP)
 file(READ "${BINDING_PATH}/enum.h.tmpl" BINDING_ENUM_H)
 file(READ "${BINDING_PATH}/enum.cpp.tmpl" BINDING_ENUM_CPP)
 file(READ "${BINDING_PATH}/function.h.tmpl" BINDING_FUNCTION_H)
@@ -18,6 +19,7 @@ file(READ "${BINDING_PATH}/typedef.h.tmpl" BINDING_TYPEDEF_H)
 file(READ "${BINDING_PATH}/typedef.cpp.tmpl" BINDING_TYPEDEF_CPP)
 file(READ "${BINDING_PATH}/module.h.tmpl" BINDING_MODULE_H)
 file(READ "${BINDING_PATH}/module.cpp.tmpl" BINDING_MODULE_CPP)
+file(READ "${BINDING_PATH}/prefix.h.tmpl" BINDING_PREFIX_H)
 
 # Uses a binding template to assemble the above files into a header.
 configure_file("${BINDING_TEMPLATE}" "${BINDING_OUTPUT}"
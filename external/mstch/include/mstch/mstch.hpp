@@ -126,4 +126,20 @@ std::string render(
     const std::map<std::string,std::string>& partials =
         std::map<std::string,std::string>());
 
+////////////////////////////
+// MODIFIED FOR CHIMERA
+////////////////////////////
+
+// Evaluates the parts of a node that a template uses, and returns them as
+// plain maps, arrays and values, which render the template like the node.
+// Objects are replaced with maps of the methods that the template calls, and
+// the array elements that it does not visit are null.  Unlike objects, the
+// result may be rendered on any thread, and after the state of the objects is
+// gone.  Partials and the contents of lambdas are not evaluated.
+node extract(const std::string& tmplt, const node& root);
+
+////////////////////////////
+// END MODIFIED FOR CHIMERA
+////////////////////////////
+
 }
@@ -0,0 +1,158 @@
+#include "extract_context.hpp"
+#include "visitor/has_token.hpp"
+#include "visitor/is_node_empty.hpp"
+
+using namespace mstch;
+
+////////////////////////////
+// MODIFIED FOR CHIMERA
+////////////////////////////
+
+const mstch::node extract_context::null_node;
+
+extract_context::entry::entry(const mstch::node& node): m_value(&node) {
+}
+
+extract_context::entry::entry(mstch::node&& node):
+    m_owned(new mstch::node(std::move(node))), m_value(m_owned.get())
+{
+}
+
+extract_context::entry& extract_context::entry::member(
+    const std::string& name)
+{
+  auto it = m_members.find(name);
+  if (it != m_members.end())
+    return *it->second;
+
+  // Like get_token, any other node is its own "." member.
+  std::unique_ptr<entry> found;
+  if (auto map = boost::get<mstch::map>(m_value))
+    found.reset(new entry(map->at(name)));
+  else if (auto object = boost::get<std::shared_ptr<mstch::object>>(m_value))
+    found.reset(new entry(mstch::node((*object)->at(name))));
+  else
+    return *this;
+  return *m_members.emplace(name, std::move(found)).first->second;
+}
+
+extract_context::entry& extract_context::entry::item(std::size_t index) {
+  auto& found = m_items[index];
+  if (!found)
+    found.reset(new entry(boost::get<mstch::array>(*m_value).at(index)));
+  return *found;
+}
+
+mstch::node extract_context::entry::plain() const {
+  if (boost::get<mstch::map>(m_value)
+      || boost::get<std::shared_ptr<mstch::object>>(m_value))
+  {
+    mstch::map members;
+    for (auto& member: m_members)
+      members.emplace(member.first, member.second->plain());
+    return members;
+  }
+
+  if (auto array = boost::get<mstch::array>(m_value)) {
+    mstch::array items(array->size());
+    for (auto& item: m_items)
+      items[item.first] = item.second->plain();
+    return items;
+  }
+
+  return *m_value;
+}
+
+extract_context::extract_context(const mstch::node& node):
+    m_root(node), m_null(null_node), m_entries(1, &m_root)
+{
+}
+
+void extract_context::extract(const template_type& templt) {
+  for (auto it = templt.begin(); it != templt.end(); ++it) {
+    switch (it->token_type()) {
+      case token::type::variable:
+      case token::type::unescaped_variable:
+        find_entry(it->name(), m_entries);
+        break;
+      case token::type::section_open:
+      case token::type::inverted_section_open: {
+        // Collect the section like in_section does.
+        const token& start_token = *it;
+        template_type section;
+        int skipped_openings = 0;
+        for (++it; it != templt.end(); ++it) {
+          if (it->token_type() == token::type::section_close) {
+            if (it->name() == start_token.name() && skipped_openings == 0)
+              break;
+            skipped_openings--;
+          } else if (it->token_type() == token::type::inverted_section_open ||
+              it->token_type() == token::type::section_open)
+            skipped_openings++;
+          section << *it;
+        }
+
+        // An unclosed section renders nothing.
+        if (it == templt.end())
+          return;
+        extract_section(start_token, section);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+mstch::node extract_context::plain() const {
+  return m_root.plain();
+}
+
+extract_context::entry& extract_context::find_entry(
+    const std::string& token,
+    std::list<entry*> entries)
+{
+  if (token != "." && token.find('.') != std::string::npos)
+    return find_entry(token.substr(token.rfind('.') + 1),
+        {&find_entry(token.substr(0, token.rfind('.')), entries)});
+  else
+    for (auto& entry: entries)
+      if (visit(has_token(token), entry->value()))
+        return entry->member(token);
+  return m_null;
+}
+
+void extract_context::extract_section(
+    const token& start_token, const template_type& section)
+{
+  auto& found = find_entry(start_token.name(), m_entries);
+  const bool empty = visit(is_node_empty(), found.value());
+
+  if (start_token.token_type() == token::type::section_open && !empty) {
+    // Like render_section, each element of an array is rendered on its own,
+    // and the section text of a lambda is left to the lambda.
+    if (auto array = boost::get<mstch::array>(&found.value()))
+      for (std::size_t index = 0; index < array->size(); ++index) {
+        auto& item = found.item(index);
+        if (boost::get<mstch::lambda>(&item.value()))
+          continue;
+        m_entries.push_front(&item);
+        extract(section);
+        m_entries.pop_front();
+      }
+    else if (!boost::get<mstch::lambda>(&found.value())) {
+      m_entries.push_front(&found);
+      extract(section);
+      m_entries.pop_front();
+    }
+  } else if (start_token.token_type() == token::type::inverted_section_open &&
+      empty) {
+    m_entries.push_front(&m_null);
+    extract(section);
+    m_entries.pop_front();
+  }
+}
+
+////////////////////////////
+// END MODIFIED FOR CHIMERA
+////////////////////////////
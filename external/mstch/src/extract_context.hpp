@@ -0,0 +1,58 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "mstch/mstch.hpp"
+#include "template_type.hpp"
+
+namespace mstch {
+
+////////////////////////////
+// MODIFIED FOR CHIMERA
+////////////////////////////
+
+// Walks a template like render_context, but records the nodes that it looks
+// up instead of rendering them.
+class extract_context {
+ public:
+  extract_context(const mstch::node& node);
+  void extract(const template_type& templt);
+  mstch::node plain() const;
+
+ private:
+  // A node that was looked up, with the members and array elements that were
+  // looked up in it.  The value of an object method is kept by the entry,
+  // since the object reuses its storage for the next evaluation.
+  class entry {
+   public:
+    entry(const mstch::node& node);
+    entry(mstch::node&& node);
+    const mstch::node& value() const { return *m_value; }
+    entry& member(const std::string& name);
+    entry& item(std::size_t index);
+    mstch::node plain() const;
+
+   private:
+    std::unique_ptr<mstch::node> m_owned;
+    const mstch::node* m_value;
+    std::map<std::string, std::unique_ptr<entry>> m_members;
+    std::map<std::size_t, std::unique_ptr<entry>> m_items;
+  };
+
+  static const mstch::node null_node;
+  entry& find_entry(const std::string& token, std::list<entry*> entries);
+  void extract_section(
+      const token& start_token, const template_type& section);
+  entry m_root;
+  entry m_null;
+  std::list<entry*> m_entries;
+};
+
+////////////////////////////
+// END MODIFIED FOR CHIMERA
+////////////////////////////
+
+}
@@ -2,6 +2,7 @@
 
 #include "mstch/mstch.hpp"
 #include "render_context.hpp"
+#include "extract_context.hpp"
 
 using namespace mstch;
 
@@ -18,3 +19,17 @@ std::string mstch::render(
 
   return render_context(root, partial_templates).render(tmplt);
 }
+
+////////////////////////////
+// MODIFIED FOR CHIMERA
+////////////////////////////
+
+node mstch::extract(const std::string& tmplt, const node& root) {
+  extract_context context(root);
+  context.extract(tmplt);
+  return context.plain();
+}
+
+////////////////////////////
+// END MODIFIED FOR CHIMERA
+////////////////////////////
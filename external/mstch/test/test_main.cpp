@@ -64,6 +64,12 @@ mstch::node parse_with_rapidjson(const std::string& str) {
   REQUIRE(x ## _txt == mstch::render(x ## _mustache, x ## _data)); \
 }
 
+// MODIFIED FOR CHIMERA: an extracted node renders like the original node.
+#define MSTCH_EXTRACT_TEST(x) TEST_CASE("extract_" #x) { \
+  REQUIRE(x ## _txt == mstch::render(x ## _mustache, \
+      mstch::extract(x ## _mustache, x ## _data))); \
+}
+
 #define SPECS_TEST(x) TEST_CASE("specs_" #x) { \
   using boost::get; \
   auto data = parse_with_rapidjson(x ## _json); \
@@ -146,6 +152,22 @@ MSTCH_TEST(unescaped)
 MSTCH_TEST(whitespace)
 MSTCH_TEST(zero_view)
 
+MSTCH_EXTRACT_TEST(complex)
+MSTCH_EXTRACT_TEST(context_lookup)
+MSTCH_EXTRACT_TEST(dot_notation)
+MSTCH_EXTRACT_TEST(falsy_array)
+MSTCH_EXTRACT_TEST(grandparent_context)
+MSTCH_EXTRACT_TEST(implicit_iterator)
+MSTCH_EXTRACT_TEST(inverted_section)
+MSTCH_EXTRACT_TEST(nested_dot)
+MSTCH_EXTRACT_TEST(nested_iterating)
+MSTCH_EXTRACT_TEST(nesting_same_name)
+MSTCH_EXTRACT_TEST(null_lookup_array)
+MSTCH_EXTRACT_TEST(recursion_with_same_names)
+MSTCH_EXTRACT_TEST(reuse_of_enumerables)
+MSTCH_EXTRACT_TEST(section_as_context)
+MSTCH_EXTRACT_TEST(string_as_context)
+
 SPECS_TEST(comments)
 SPECS_TEST(delimiters)
 SPECS_TEST(interpolation)
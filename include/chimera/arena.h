@@ -0,0 +1,93 @@
+#ifndef __CHIMERA_ARENA_H__
+#define __CHIMERA_ARENA_H__
+
+#include <cstddef>
+#include <mutex>
+#include <llvm/Support/Allocator.h>
+
+namespace chimera
+{
+
+/**
+ * Bump allocator for objects that share a single lifetime.
+ *
+ * Individual deallocations are ignored; all memory is released at once when
+ * the arena is destroyed.  Allocation is thread-safe.
+ */
+class Arena
+{
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Allocates uninitialized memory with the given size and alignment.
+     */
+    void *Allocate(std::size_t size, std::size_t alignment);
+
+    /**
+     * Returns the total number of bytes that have been allocated.
+     */
+    std::size_t GetBytesAllocated() const;
+
+private:
+    mutable std::mutex mutex_;
+    llvm::BumpPtrAllocator allocator_;
+};
+
+/**
+ * Standard allocator that allocates from an Arena.
+ *
+ * This is intended for use with std::allocate_shared, so that objects that
+ * are reference-counted still have their storage released with the arena.
+ */
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena &arena) : arena_(&arena)
+    {
+        // Do nothing.
+    }
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena_)
+    {
+        // Do nothing.
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(arena_->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T * /*p*/, std::size_t /*n*/)
+    {
+        // Do nothing, the memory is released with the arena.
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const
+    {
+        return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const
+    {
+        return arena_ != other.arena_;
+    }
+
+private:
+    Arena *arena_;
+
+    template <typename U>
+    friend class ArenaAllocator;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_ARENA_H__
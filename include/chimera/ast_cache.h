@@ -0,0 +1,68 @@
+#ifndef __CHIMERA_AST_CACHE_H__
+#define __CHIMERA_AST_CACHE_H__
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace chimera
+{
+
+/**
+ * A cache of serialized translation units.
+ *
+ * The AST of each compile command is saved to a directory as it is parsed.
+ * ASTs are keyed by a hash of the compile command, the input file and the
+ * chimera and clang versions, and are loaded by later runs instead of being
+ * parsed again until the content of any of the files they were parsed from
+ * changes.
+ */
+class ASTCache
+{
+public:
+    explicit ASTCache(const std::string &directory);
+
+    /**
+     * Finds the cached AST of a compile command, whose arguments are
+     * extended by the given arguments.  Returns true if the AST at the
+     * returned path is up to date.  Otherwise, any stale AST is removed, and
+     * the AST should be saved to the returned path.
+     */
+    bool Find(const clang::tooling::CompileCommand &command,
+              const std::vector<std::string> &arguments,
+              std::string &ast_path);
+
+    /**
+     * Records the files that a saved AST was parsed from.
+     */
+    void AddSavedAST(const std::string &ast_path,
+                     const std::vector<std::string> &input_files);
+
+    /**
+     * Records the inputs of the ASTs that were saved, which makes them
+     * available to later runs.
+     */
+    void Commit();
+
+    /**
+     * Returns the files that the ASTs found up to date were parsed from.
+     */
+    const std::vector<std::string> &GetInputFiles() const;
+
+    /**
+     * Returns the number of ASTs found up to date.
+     */
+    std::size_t GetNumFound() const;
+
+private:
+    std::string directory_;
+    std::vector<std::pair<std::string, std::vector<std::string>>> saved_;
+    std::vector<std::string> input_files_;
+    std::size_t num_found_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_AST_CACHE_H__
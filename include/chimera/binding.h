@@ -16,12 +16,14 @@ struct Definition
 {
     std::string class_h;
     std::string class_cpp;
+    std::string class_part_cpp;
     std::string enum_h;
     std::string enum_cpp;
     std::string function_h;
     std::string function_cpp;
     std::string module_h;
     std::string module_cpp;
+    std::string prefix_h;
     std::string variable_h;
     std::string variable_cpp;
     std::string typedef_h;
@@ -1,11 +1,18 @@
 #ifndef __CHIMERA_CONFIGURATION_H__
 #define __CHIMERA_CONFIGURATION_H__
 
+#include "chimera/arena.h"
 #include "chimera/binding.h"
+#include "chimera/dependency_graph.h"
+#include "chimera/output_writer.h"
+#include "chimera/statistics.h"
+#include "chimera/thread_pool.h"
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
+#include <boost/optional.hpp>
 #include <clang/AST/DeclBase.h>
 #include <clang/AST/Mangle.h>
 #include <clang/Frontend/CompilerInstance.h>
@@ -33,6 +40,54 @@ namespace chimera
 
 class CompiledConfiguration;
 
+/**
+ * Typed configuration of a single declaration.
+ *
+ * The keys that chimera itself interprets are converted from the YAML
+ * configuration once, when the configuration is compiled, rather than every
+ * time a template wrapper is evaluated.  Unset keys are left empty.
+ */
+struct DeclarationConfig
+{
+    /**
+     * The raw YAML configuration of the declaration.  This is a null node
+     * for suppressed declarations and undefined for unconfigured ones.
+     */
+    YAML::Node node = YAML::Node(YAML::NodeType::Undefined);
+
+    /**
+     * Binding name.  A `null` name is converted to an empty string, which
+     * marks a name that should be omitted.
+     */
+    boost::optional<std::string> name;
+    boost::optional<std::string> mangled_name;
+    boost::optional<std::string> qualified_name;
+    boost::optional<std::string> type;
+    boost::optional<std::string> return_type;
+    boost::optional<std::string> return_value_policy;
+    boost::optional<std::string> call;
+    boost::optional<std::string> qualified_call;
+    boost::optional<std::string> held_type;
+    boost::optional<bool> is_copyable;
+    boost::optional<bool> is_assignable;
+
+    /**
+     * Explicit list of base classes, or an undefined node if unset.
+     */
+    YAML::Node bases = YAML::Node(YAML::NodeType::Undefined);
+};
+
+/**
+ * Layout of the generated bindings in the output directory.
+ */
+enum class OutputLayout
+{
+    Flat,     ///< All files are written to the output directory itself.
+    Hash,     ///< Bindings are spread over 256 hashed subdirectories.
+    Namespace ///< Bindings are nested in subdirectories named after their
+              ///< enclosing namespaces.
+};
+
 class Configuration
 {
 public:
@@ -45,6 +100,12 @@ public:
      */
     void LoadFile(const std::string &filename);
 
+    /**
+     * Uses the YAML configuration that another configuration loaded from the
+     * specified file, without reading the file again.
+     */
+    void SetRoot(const YAML::Node &root, const std::string &filename);
+
     /**
      * Sets the desired binding definition by name.
      * If unspecified, the default is "boost_python".
@@ -80,6 +141,191 @@ public:
      */
     void SetStrict(bool val);
 
+    /**
+     * Sets a path to which the dependency graph of the generated bindings is
+     * written in Graphviz DOT format.
+     * If unspecified, the dependency graph is not written.
+     */
+    void SetDependencyGraphPath(const std::string &path);
+
+    /**
+     * Sets whether to free the compiler instance and its AST before the
+     * bindings are rendered.
+     *
+     * In this mode, the parts of the AST that the templates use are copied
+     * into plain data while the declarations are traversed, and the bindings
+     * are only rendered from it by RenderDeferredOutputs(), after the tool
+     * has run.
+     */
+    void SetReleaseAST(bool val);
+
+    /**
+     * Returns whether to free the compiler instance and its AST before the
+     * bindings are rendered.
+     */
+    bool GetReleaseAST() const;
+
+    /**
+     * Sets the number of rendered bindings that may wait for a background
+     * thread to write them, so that rendering continues while files are
+     * compared and written.  Write failures are then reported when the output
+     * writer is flushed, after the tool has run.
+     * If unspecified or zero, bindings are written as they are rendered.
+     */
+    void SetWriteQueueSize(unsigned size);
+
+    /**
+     * Sets the number of unity translation units into which the binding
+     * sources are merged.  Each unity source includes a subset of the
+     * binding sources, which are then no longer listed as outputs.
+     * If unspecified or zero, every binding source is compiled separately.
+     */
+    void SetUnityFileCount(unsigned count);
+
+    /**
+     * Sets the number of instance method overloads above which the binding
+     * of a class is split across several source files.  The class source
+     * registers the first methods and calls a part function for each of the
+     * remaining groups of methods, which is rendered into its own file.
+     * If unspecified or zero, classes are never split.
+     */
+    void SetClassSplitThreshold(unsigned threshold);
+
+    /**
+     * Sets whether each binding only includes the headers that declare its
+     * declaration and the types that it uses, instead of every source.
+     *
+     * Headers are resolved to the file that the source includes directly,
+     * spelled relative to the include paths of the compilation.
+     */
+    void SetMinimalIncludes(bool val);
+
+    /**
+     * Sets whether to render a prefix header for the module, which includes
+     * the binding framework and the sources that are included by at least
+     * half of the bindings.  It is suitable for use as a precompiled header.
+     */
+    void SetPrefixHeader(bool val);
+
+    /**
+     * Sets whether to only list the files that would be generated, without
+     * rendering or writing them.  The listed files are the same as the ones
+     * listed by a full run with the same options.  Neither the depfile nor
+     * the dependency graph is written.
+     */
+    void SetListOutputs(bool val);
+
+    /**
+     * Sets the layout of the generated bindings in the output directory.
+     * Top-level files are always written to the output directory itself, and
+     * the listed outputs are relative to it.
+     * If unspecified, the default is OutputLayout::Flat.
+     */
+    void SetOutputLayout(OutputLayout layout);
+
+    /**
+     * Sets the number of threads that render the bindings.  The declarations
+     * are still traversed by a single thread, which evaluates the parts of
+     * the AST that the templates of each declaration use.  The templates are
+     * expanded and written by the threads while the traversal continues,
+     * starting with the most expensive of the waiting declarations.  The
+     * outputs are the same as the ones rendered by a single thread.
+     * If unspecified or zero, the bindings are rendered by a single thread.
+     */
+    void SetRenderThreadCount(unsigned count);
+
+    /**
+     * Sets the shard of the bindings that this run renders, out of a number
+     * of shards.  Each binding file belongs to the shard given by a stable
+     * hash of its name, and the top-level files belong to the first shard.
+     * Every shard still processes all declarations, so the top-level files
+     * are the same as the ones of an unsharded run.
+     * If unspecified or the count is one, the bindings are not sharded.
+     */
+    void SetShard(unsigned index, unsigned count);
+
+    /**
+     * Returns whether this run only renders one shard of the bindings.
+     */
+    bool IsSharded() const;
+
+    /**
+     * Sets a path to which a Makefile-style depfile is written, listing every
+     * file that the generated bindings depend on as prerequisites of the
+     * given target.  If the target is empty, the top-level source is used.
+     * If unspecified, no depfile is written.
+     */
+    void SetDepfile(const std::string &path, const std::string &target);
+
+    /**
+     * Records a file that the generated bindings depend on.
+     */
+    void AddInputFile(const std::string &path) const;
+
+    /**
+     * Returns the absolute paths of the files that the generated bindings
+     * depend on.
+     */
+    const std::set<std::string> &GetInputFiles() const;
+
+    /**
+     * Writes a rendered binding with the output writer.  The name of the
+     * declaration that the binding was rendered for, if any, is used to
+     * report a failure.
+     * Throws a std::runtime_error if the file could not be created.
+     */
+    void WriteOutput(const std::string &path, const std::string &content,
+                     const std::string &name) const;
+
+    /**
+     * Records a binding that is rendered once the AST has been released,
+     * from plain data that was extracted for its template.
+     */
+    void AddDeferredOutput(const std::string &path, const std::string &view,
+                           ::mstch::node context,
+                           const std::string &name) const;
+
+    /**
+     * Renders and writes the bindings that were deferred until the AST was
+     * released, on the render threads.
+     * Throws a std::runtime_error if a binding could not be written.
+     */
+    void RenderDeferredOutputs() const;
+
+    /**
+     * Writes the depfile, if one was requested.
+     */
+    void WriteDepfile() const;
+
+    /**
+     * Records an output that is listed on stdout, along with its position
+     * among the outputs that an unsharded run would list.
+     */
+    void AddListedOutput(std::size_t position, const std::string &path) const;
+
+    /**
+     * Writes the listing of the shard that this run rendered to the output
+     * directory, which records the outputs that it listed and the files that
+     * it wrote.
+     */
+    void WriteShardListing() const;
+
+    /**
+     * Combines the listings of all shards of a sharded run.  The outputs
+     * that the shards listed are listed on stdout, in the order in which an
+     * unsharded run would list them, and the files that they wrote are kept
+     * by the output writer.
+     * Throws a std::runtime_error if the listing of any shard is missing.
+     */
+    void MergeShards(unsigned count) const;
+
+    /**
+     * Removes the outputs of a previous run that were not generated by this
+     * run, and records the outputs of this run in the module manifest.
+     * Each removed file is reported to stderr.
+     */
+    void RemoveStaleOutputs() const;
+
     /**
      * Processes the configuration settings against the current AST.
      */
@@ -106,6 +352,17 @@ public:
      */
     const std::string &GetOutputModuleName() const;
 
+    /**
+     * Gets the statistics that are collected over the run that uses this
+     * configuration.
+     */
+    chimera::Statistics &GetStatistics() const;
+
+    /**
+     * Gets the writer that is used to output the rendered bindings.
+     */
+    chimera::OutputWriter &GetOutputWriter() const;
+
 protected:
     YAML::Node configNode_;
     std::string bindingName_;
@@ -115,6 +372,35 @@ protected:
     std::vector<std::string> inputNamespaceNames_;
     std::vector<std::string> inputSourcePaths_;
     bool strict_;
+    std::string dependencyGraphPath_;
+    bool releaseAST_;
+    unsigned unityFileCount_;
+    unsigned classSplitThreshold_;
+    bool minimalIncludes_;
+    bool prefixHeader_;
+    bool listOutputs_;
+    OutputLayout outputLayout_;
+    std::string depfilePath_;
+    std::string depfileTarget_;
+    unsigned renderThreadCount_;
+    unsigned shardIndex_;
+    unsigned shardCount_;
+    mutable std::set<std::string> inputFiles_;
+    mutable std::vector<std::pair<std::size_t, std::string>> listedOutputs_;
+    mutable chimera::Statistics statistics_;
+    mutable chimera::OutputWriter outputWriter_;
+
+    // Bindings that are rendered once the AST has been released.  Their
+    // templates are shared, since there are only a few of them.
+    struct DeferredOutput
+    {
+        std::string path;
+        const std::string *view;
+        ::mstch::node context;
+        std::string name;
+    };
+    mutable std::set<std::string> deferredViews_;
+    mutable std::vector<DeferredOutput> deferredOutputs_;
 
     friend class CompiledConfiguration;
 };
@@ -158,6 +444,13 @@ public:
      */
     const YAML::Node &GetDeclaration(const clang::Decl *decl) const;
 
+    /**
+     * Gets the typed configuration associated with a specific declaration,
+     * or an empty configuration if no configuration was found.
+     */
+    const DeclarationConfig &GetDeclarationConfig(
+        const clang::Decl *decl) const;
+
     /**
      * Gets the YAML configuration associated with a specific qualified type,
      * or return an empty YAML node if no configuration was found.
@@ -174,6 +467,31 @@ public:
      */
     clang::ASTContext &GetContext() const;
 
+    /**
+     * Gets the dependency graph of the bindings rendered so far.
+     */
+    chimera::DependencyGraph &GetDependencyGraph();
+    const chimera::DependencyGraph &GetDependencyGraph() const;
+
+    /**
+     * Creates a template wrapper for this configuration, allocated from an
+     * arena that is released along with the configuration.
+     *
+     * The wrapper is constructed with this configuration as its first
+     * argument, and must not outlive the configuration.
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> MakeWrapper(Args &&... args) const
+    {
+        return std::allocate_shared<T>(chimera::ArenaAllocator<T>(arena_),
+                                       *this, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Returns the number of bytes allocated for template wrappers.
+     */
+    std::size_t GetWrapperBytesAllocated() const;
+
     /**
      * Gets the binding name of this configuration.
      *
@@ -212,6 +530,15 @@ public:
      */
     std::string Lookup(const YAML::Node &node) const;
 
+    /**
+     * Returns the path of the header of a binding relative to the output
+     * directory, which includes the subdirectory of the output layout.  Other
+     * bindings include it by this path, with the output directory on their
+     * include path.
+     */
+    std::string GetHeaderPath(const clang::Decl *decl,
+                              const std::string &mangled_name) const;
+
     /**
      * Renders a particular mstch template based on some declaration.
      * This context must contain a "mangled_name" from which to create the
@@ -227,6 +554,8 @@ public:
     /**
      * Renders the top-level mstch template. The rendered filename is specified
      * by Configuration::SetOutputModuleName().
+     *
+     * Bindings are listed in the dependency order of the dependency graph.
      */
     void Render();
 
@@ -234,18 +563,45 @@ private:
     CompiledConfiguration(const Configuration &parent,
                           clang::CompilerInstance *ci);
 
-    bool Render(const std::string &key, const std::string &header_view,
-                const std::string &source_view,
+    bool RenderClass(const std::shared_ptr<chimera::mstch::CXXRecord> context);
+    bool Render(const std::string &key, const clang::Decl *decl,
+                const std::string &header_view, const std::string &source_view,
                 const std::shared_ptr<::mstch::object> &template_context);
+    bool RenderSource(const std::string &mangled_name, const std::string &view,
+                      const std::shared_ptr<::mstch::object> &context,
+                      const ::mstch::map &full_context, std::size_t cost);
+    ::mstch::map CreateFileContext(
+        const std::string &key, const clang::Decl *decl,
+        const std::shared_ptr<::mstch::object> &context) const;
+    ::mstch::array GetMinimalSources(const clang::Decl *decl) const;
+    clang::FileID GetIncludeFile(clang::SourceLocation loc) const;
+    std::string GetIncludePath(clang::FileID file_id) const;
     bool Render(const std::string &mangled_name, const std::string &view,
                 const std::string &extension,
                 const std::shared_ptr<::mstch::object> &context,
-                const ::mstch::map &full_context);
+                const ::mstch::map &full_context, bool listed = true);
+    std::string GetBindingPath(const std::string &mangled_name,
+                               const std::string &extension) const;
+    std::string GetOutputName(const clang::Decl *decl,
+                              const std::string &mangled_name) const;
+    std::string GetRelativePath(const std::string &binding_path) const;
+    bool IsRenderedByShard(const std::string &mangled_name,
+                           bool top_level) const;
+    void SubmitPendingOutputs(std::size_t cost);
+    void RenderUnitySources();
+    void RenderPrefixHeader();
     void SetBindingDefinitions(const std::string &key, std::string &header_def,
                                std::string &source_def);
+    void SetClassPartDefinition(std::string &part_def);
 
 protected:
     static const YAML::Node emptyNode_;
+    static const DeclarationConfig emptyDeclarationConfig_;
+
+    // The arena must be declared before any member that holds wrappers, so
+    // that it is destroyed after them.
+    mutable chimera::Arena arena_;
+
     const Configuration &parent_;
     const YAML::Node configNode_;
     const YAML::Node bindingNode_;
@@ -253,16 +609,38 @@ protected:
     chimera::binding::Definition bindingDefinition_;
     clang::CompilerInstance *ci_;
     std::vector<std::pair<const clang::QualType, YAML::Node>> types_;
-    std::map<const clang::Decl *, YAML::Node> declarations_;
+    std::map<const clang::Decl *, DeclarationConfig> declarations_;
+
+    // Held types of the classes, which are resolved up front for the minimal
+    // includes, since resolving a type parses it.
+    std::map<const clang::Decl *, clang::QualType> heldTypes_;
     std::set<const clang::NamespaceDecl *> namespacesIncluded_;
     std::set<const clang::NamespaceDecl *> namespacesSuppressed_;
 
-    std::vector<std::string> binding_names_;
+    chimera::DependencyGraph dependency_graph_;
     std::vector<std::shared_ptr<chimera::mstch::Namespace>> binding_namespaces_;
     std::set<const clang::NamespaceDecl *> binding_namespace_decls_;
 
+    // Filenames of the binding sources merged into unity sources, along with
+    // their estimated compilation cost.
+    std::vector<std::pair<std::string, std::size_t>> unity_sources_;
+
+    // Number of bindings that include each source, in order of first use.
+    std::vector<std::pair<std::string, std::size_t>> source_counts_;
+    std::map<std::string, std::size_t> source_count_indices_;
+
     bool strict_;
 
+    // Number of outputs that were listed so far, counting those of the other
+    // shards, which gives the position of each output in an unsharded run.
+    std::size_t listed_output_count_;
+
+    // Outputs of the current declaration that are still to be handed to the
+    // render threads, which render the outputs of the previous declarations
+    // during the traversal.
+    std::vector<std::function<void()>> pending_outputs_;
+    chimera::ThreadPool render_pool_;
+
     friend class Configuration;
 };
 
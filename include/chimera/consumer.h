@@ -3,24 +3,29 @@
 
 #include "chimera/configuration.h"
 
+#include <vector>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Frontend/CompilerInstance.h>
 
 namespace chimera
 {
 
+/**
+ * Generates the bindings of each configuration from a translation unit.
+ */
 class Consumer : public clang::ASTConsumer
 {
 public:
     // Overrides the constructor in order to receive CompilerInstance.
-    Consumer(clang::CompilerInstance *ci, const chimera::Configuration &config);
+    Consumer(clang::CompilerInstance *ci,
+             const std::vector<const chimera::Configuration *> &configs);
 
     // Overrides method to call our ChimeraVisitor on the entire source file.
     void HandleTranslationUnit(clang::ASTContext &context) override;
 
 private:
     clang::CompilerInstance *ci_;
-    const chimera::Configuration &config_;
+    std::vector<const chimera::Configuration *> configs_;
 };
 
 } // namespace chimera
@@ -0,0 +1,113 @@
+#ifndef __CHIMERA_DEPENDENCY_GRAPH_H__
+#define __CHIMERA_DEPENDENCY_GRAPH_H__
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/Type.h>
+
+namespace chimera
+{
+
+/**
+ * Graph of the generated bindings and the declarations they depend on.
+ *
+ * Each binding that is rendered becomes a node, identified by its canonical
+ * declaration.  Dependencies are recorded between declarations, and are only
+ * considered between declarations that were actually rendered, so they can
+ * be added before or after the corresponding bindings.
+ *
+ * Dependencies are either hard (base classes, enclosing classes and the
+ * underlying classes of typedefs), which must be registered first, or soft
+ * (field, parameter and return types), which should be registered first
+ * when possible but may form cycles.
+ */
+class DependencyGraph
+{
+public:
+    enum class Dependency
+    {
+        Base,       ///< The declaration derives from the dependency.
+        Enclosing,  ///< The declaration is nested inside the dependency.
+        Underlying, ///< The declaration is a typedef of the dependency.
+        Type        ///< The declaration uses the dependency as a type.
+    };
+
+    /**
+     * Adds a rendered binding for a declaration.
+     *
+     * Bindings are otherwise ordered by the order in which they were added.
+     */
+    void AddBinding(const clang::Decl *decl, const std::string &name);
+
+    /**
+     * Records that a declaration depends on another declaration.
+     */
+    void AddDependency(const clang::Decl *decl, const clang::Decl *dependency,
+                       Dependency kind);
+
+    /**
+     * Records a soft dependency on the class or enum referred to by a type,
+     * looking through pointers, references and arrays.
+     */
+    void AddTypeDependency(const clang::Decl *decl, clang::QualType type);
+
+    /**
+     * Returns the public base classes of a class declaration.
+     *
+     * This is memoized, since it is needed both during traversal and while
+     * rendering the class.
+     */
+    const std::set<const clang::CXXRecordDecl *> &GetBaseClassDecls(
+        const clang::CXXRecordDecl *decl) const;
+
+    /**
+     * Returns the names of the bindings in an order in which each binding
+     * follows the bindings that it depends on.
+     *
+     * Ties are broken by the order in which bindings were added, so the
+     * result is deterministic.  Cycles through soft dependencies are broken
+     * at the earliest added binding whose hard dependencies are satisfied.
+     */
+    std::vector<std::string> GetTopologicalOrder() const;
+
+    /**
+     * Writes the graph of rendered bindings in Graphviz DOT format.
+     * Hard dependencies are drawn as solid edges, soft ones as dashed edges.
+     */
+    void WriteDot(std::ostream &os) const;
+
+    /**
+     * Returns the number of bindings in the graph.
+     */
+    std::size_t GetNumBindings() const;
+
+private:
+    struct Edge
+    {
+        std::size_t from;
+        std::size_t to;
+        bool hard;
+    };
+
+    /**
+     * Returns the dependencies between rendered bindings, where each edge
+     * points from a binding to a binding that it depends on.
+     */
+    std::vector<Edge> GetEdges() const;
+
+    std::vector<std::pair<const clang::Decl *, std::string>> bindings_;
+    std::map<const clang::Decl *, std::size_t> binding_indices_;
+    std::map<const clang::Decl *, std::map<const clang::Decl *, Dependency>>
+        dependencies_;
+    mutable std::map<const clang::CXXRecordDecl *,
+                     std::set<const clang::CXXRecordDecl *>>
+        base_class_decls_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_DEPENDENCY_GRAPH_H__
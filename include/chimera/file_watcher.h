@@ -0,0 +1,60 @@
+#ifndef __CHIMERA_FILE_WATCHER_H__
+#define __CHIMERA_FILE_WATCHER_H__
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+
+namespace chimera
+{
+
+/**
+ * Watches a set of files for changes.
+ *
+ * The directories of the files are watched rather than the files themselves,
+ * so that files which editors replace by renaming are still noticed.  This
+ * is only supported on Linux, where it uses inotify.
+ *
+ * Changes are recorded from the moment that a file is watched, so the files
+ * that change while the watcher is not waiting are reported by the next wait.
+ */
+class FileWatcher
+{
+public:
+    /**
+     * Creates a watcher that does not watch any files yet.
+     * Throws a std::runtime_error if files cannot be watched at all.
+     */
+    FileWatcher();
+    ~FileWatcher();
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    /**
+     * Watches the given files instead of the ones that were watched before.
+     * Throws a std::runtime_error if the directory of any file cannot be
+     * watched, for example because it was removed, after watching the other
+     * files.
+     */
+    void SetPaths(const std::set<std::string> &paths);
+
+    /**
+     * Blocks until any of the files changes, then waits until none of them
+     * has changed for the debounce interval.  Returns the paths of the files
+     * that changed.  If the timeout is not negative, returns no paths if none
+     * of the files changes within it.
+     */
+    std::set<std::string> Wait(
+        std::chrono::milliseconds debounce,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(-1));
+
+private:
+    int fd_;
+    std::map<int, std::string> directories_;
+    std::set<std::string> paths_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_FILE_WATCHER_H__
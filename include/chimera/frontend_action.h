@@ -1,10 +1,12 @@
 #ifndef __CHIMERA_FRONTEND_ACTION_H__
 #define __CHIMERA_FRONTEND_ACTION_H__
 
+#include "chimera/ast_cache.h"
 #include "chimera/configuration.h"
 #include "chimera/util.h"
 
 #include <memory>
+#include <vector>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Frontend/FrontendActions.h>
@@ -15,18 +17,31 @@ namespace chimera
 
 /**
  * Front-end that runs the Chimera AST consumer on the provided source.
+ *
+ * The source may also be a serialized AST.  If an output file is given for a
+ * parsed source, its AST is saved to that file and recorded in the AST cache.
+ *
+ * Only the first translation unit of a run is handled, which is tracked by
+ * a flag that the actions of a run share.
  */
 class FrontendAction : public clang::ASTFrontendAction
 {
 public:
     // Overrides the constructor in order to receive ChimeraConfiguration.
-    FrontendAction(const chimera::Configuration &config);
+    FrontendAction(const std::vector<const chimera::Configuration *> &configs,
+                   chimera::ASTCache *ast_cache = nullptr,
+                   bool *handled = nullptr);
 
     std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(
         clang::CompilerInstance &CI, clang::StringRef file) override;
 
+    void EndSourceFileAction() override;
+
 protected:
-    const chimera::Configuration &config_;
+    std::vector<const chimera::Configuration *> configs_;
+    chimera::ASTCache *ast_cache_;
+    bool *handled_;
+    std::string ast_path_;
 };
 
 // Create a custom action factory that forwards the ChimeraConfiguration.
@@ -34,7 +49,9 @@ class ChimeraFrontendActionFactory
   : public clang::tooling::FrontendActionFactory
 {
 public:
-    ChimeraFrontendActionFactory(const chimera::Configuration &config);
+    ChimeraFrontendActionFactory(
+        const std::vector<const chimera::Configuration *> &configs,
+        chimera::ASTCache *ast_cache = nullptr);
 
 // Between Clang 9 and Clang 10, the return value for
 // FrontendActionFactory::create() changed from raw pointer to std::unique_ptr.
@@ -45,14 +62,17 @@ public:
 #endif
 
 protected:
-    const chimera::Configuration &config_;
+    std::vector<const chimera::Configuration *> configs_;
+    chimera::ASTCache *ast_cache_;
+    bool handled_;
 };
 
 /**
  * Custom frontend factory that forwards a ChimeraConfiguration.
  */
 std::unique_ptr<clang::tooling::FrontendActionFactory> newFrontendActionFactory(
-    const chimera::Configuration &config);
+    const std::vector<const chimera::Configuration *> &configs,
+    chimera::ASTCache *ast_cache = nullptr);
 
 } // namespace chimera
 
@@ -0,0 +1,208 @@
+#ifndef __CHIMERA_GENERATOR_H__
+#define __CHIMERA_GENERATOR_H__
+
+#include "chimera/configuration.h"
+#include "chimera/incremental_parser.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace chimera
+{
+
+/**
+ * Options for generating one of several modules from the same sources.  Any
+ * option that is left empty is taken from the generator options.
+ */
+struct ModuleOptions
+{
+    std::vector<std::string> binding_names;
+    std::string module_name;
+    std::string output_path;
+    std::string config_filename;
+    std::vector<std::string> namespace_names;
+    std::string depfile_path;
+};
+
+/**
+ * Parses a module specification of comma-separated `key=value` pairs, where
+ * the keys are `binding`, `name`, `output`, `config`, `namespace` and
+ * `depfile`.  The `binding` and `namespace` keys may be repeated.
+ * Throws a std::invalid_argument if the specification is malformed.
+ */
+ModuleOptions parseModuleSpec(const std::string &spec);
+
+/**
+ * Parses a shard specification of the form `index/count`, where the index is
+ * less than the count.
+ * Throws a std::invalid_argument if the specification is malformed.
+ */
+void parseShardSpec(const std::string &spec, unsigned &index, unsigned &count);
+
+/**
+ * Options for generating bindings, which mirror the command-line options of
+ * chimera.
+ */
+struct GeneratorOptions
+{
+    /**
+     * Bindings that are generated from one parse of the sources.  If there
+     * are several, each is written to a subdirectory of the output path that
+     * is named after it.  If empty, the bindings are taken from the YAML
+     * configuration.
+     */
+    std::vector<std::string> binding_names;
+
+    std::string output_path;
+    std::string module_name;
+    std::vector<std::string> namespace_names;
+    std::string config_filename;
+    bool use_c_mode = false;
+    bool suppress_docs = false;
+    bool suppress_sources = false;
+    bool strict = false;
+    std::string dependency_graph_path;
+    bool release_ast = false;
+    unsigned unity_file_count = 0;
+
+    /**
+     * Number of threads that render and write the bindings.  If zero or one,
+     * the bindings are rendered by the thread that parses the sources.
+     */
+    unsigned jobs = 0;
+
+    /**
+     * Number of rendered bindings that may wait for a background thread to
+     * write them.  If zero, the bindings are written as they are rendered.
+     */
+    unsigned write_queue_size = 0;
+
+    unsigned class_split_threshold = 0;
+    bool minimal_includes = false;
+    bool prefix_header = false;
+    bool list_outputs = false;
+    std::string depfile_path;
+    std::string depfile_target;
+    OutputLayout output_layout = OutputLayout::Flat;
+    std::string ast_cache_path;
+    std::string pch_cache_path;
+    std::vector<std::string> pch_includes;
+
+    /**
+     * Shard of the bindings that is rendered, out of a number of shards.  If
+     * the count is zero or one, all bindings are rendered.
+     */
+    unsigned shard_index = 0;
+    unsigned shard_count = 0;
+
+    /**
+     * Modules that are generated from one parse of the sources.  If empty, a
+     * single module is generated from the options above.
+     */
+    std::vector<ModuleOptions> modules;
+};
+
+/**
+ * Generates bindings for a set of sources.
+ *
+ * All of the state of a run is held by the generator and the configurations
+ * that it runs with, so that several runs can happen in the same process.
+ *
+ * Each binding of each module is generated with its own configuration, and
+ * all of them are processed against the same parse of the sources.  The
+ * bindings of a module share its YAML configuration, but each of them still
+ * resolves it against the AST and traverses the AST on its own, since which
+ * declarations are generated depends on the templates of the binding.
+ *
+ * The YAML configuration of a module may list several bindings, either as a
+ * sequence of names, which are written to subdirectories of the output path
+ * that are named after them, or as a map from names to output directories,
+ * which are relative to the output path.
+ */
+class Generator
+{
+public:
+    Generator(const clang::tooling::CompilationDatabase &compilations,
+              const std::vector<std::string> &source_paths,
+              const GeneratorOptions &options);
+
+    /**
+     * Creates a configuration for each binding of each module, to which the
+     * options are applied.  Only the first binding of a module writes its
+     * depfile, since all of them depend on the same files.
+     * Throws a std::invalid_argument if two bindings or modules share an
+     * output directory, or two modules write the same depfile.
+     */
+    std::vector<std::unique_ptr<chimera::Configuration>> CreateConfigurations()
+        const;
+
+    /**
+     * Returns the adjuster that adds the language and documentation flags to
+     * the compile commands.
+     */
+    clang::tooling::ArgumentsAdjuster GetArgumentsAdjuster() const;
+
+    /**
+     * Generates the bindings of every configuration from one parse of the
+     * sources.  Returns zero on success.
+     */
+    int Run(
+        const std::vector<std::unique_ptr<chimera::Configuration>> &configs);
+
+    /**
+     * Combines the listings of the shards of a sharded run into the listing
+     * of the outputs of every configuration, and removes the outputs of a
+     * previous run that none of the shards generated.  The sources are not
+     * parsed.
+     */
+    void Merge(
+        const std::vector<std::unique_ptr<chimera::Configuration>> &configs,
+        unsigned shard_count);
+
+    /**
+     * Keeps the sources parsed and generates the bindings whenever a client
+     * requests it on a local socket, until a client asks to stop.
+     *
+     * A request is "generate" followed by a key that identifies the arguments
+     * and the executable of the client.  Requests with another key than the
+     * server's are answered with "mismatch", so that a client never receives
+     * bindings that were generated with other arguments or another version
+     * of chimera.
+     *
+     * The response lists the lines that a normal run prints to stdout, each
+     * prefixed by "out ", followed by the outputs that changed, each prefixed
+     * by "changed ", and any error, prefixed by "error ".
+     */
+    void Serve(const std::string &socket_path, const std::string &key);
+
+    /**
+     * Keeps the sources parsed and generates the bindings whenever any of the
+     * files that they depend on changes.  This never returns.
+     */
+    void Watch();
+
+private:
+    void Configure(chimera::Configuration &config, const ModuleOptions &module,
+                   const chimera::Configuration *loaded = nullptr) const;
+    void Finish(const chimera::Configuration &config) const;
+    std::string GetResourcePath() const;
+    std::set<std::string> GetWatchedFiles(
+        const std::vector<std::unique_ptr<chimera::Configuration>> &configs,
+        const chimera::IncrementalParser &parser) const;
+    void Regenerate(
+        chimera::IncrementalParser &parser,
+        const std::vector<std::unique_ptr<chimera::Configuration>> &configs)
+        const;
+
+    const clang::tooling::CompilationDatabase &compilations_;
+    std::vector<std::string> source_paths_;
+    GeneratorOptions options_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_GENERATOR_H__
@@ -0,0 +1,65 @@
+#ifndef __CHIMERA_INCREMENTAL_PARSER_H__
+#define __CHIMERA_INCREMENTAL_PARSER_H__
+
+#include "chimera/configuration.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace chimera
+{
+
+/**
+ * Keeps the translation units of a set of sources parsed in memory, so that
+ * chimera can be run on them repeatedly.
+ *
+ * The includes at the top of each source are compiled into a preamble, which
+ * is reused when the source is reparsed as long as the included files have
+ * not changed.
+ */
+class IncrementalParser
+{
+public:
+    /**
+     * Creates a parser for the compile commands of the given sources, which
+     * are adjusted by an arguments adjuster.  The resource path is the clang
+     * resource directory with the builtin headers.
+     */
+    IncrementalParser(const clang::tooling::CompilationDatabase &compilations,
+                      const std::vector<std::string> &source_paths,
+                      const clang::tooling::ArgumentsAdjuster &adjuster,
+                      const std::string &resource_path);
+    IncrementalParser(const IncrementalParser &) = delete;
+    IncrementalParser &operator=(const IncrementalParser &) = delete;
+
+    /**
+     * Parses the sources, or reparses them if they were parsed before.
+     * Returns false if any of the sources could not be parsed.
+     */
+    bool Parse();
+
+    /**
+     * Runs chimera on the first parsed source with each configuration, which
+     * is the translation unit that a regular run generates the bindings from.
+     */
+    void Run(const std::vector<const chimera::Configuration *> &configs);
+
+    /**
+     * Returns the files that the parsed sources were parsed from.
+     */
+    std::vector<std::string> GetInputFiles() const;
+
+private:
+    std::vector<std::vector<std::string>> command_lines_;
+    std::vector<std::unique_ptr<clang::ASTUnit>> units_;
+    std::string resource_path_;
+    std::shared_ptr<clang::PCHContainerOperations> pch_container_ops_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_INCREMENTAL_PARSER_H__
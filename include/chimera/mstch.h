@@ -36,13 +36,13 @@ public:
                  bool last = false)
       : config_(config)
       , decl_(decl)
-      , decl_config_(config_.GetDeclaration(decl_))
+      , decl_config_(config_.GetDeclarationConfig(decl_))
       , last_(last)
     {
         // Add entries from the YAML configuration directly into the object.
         // This wraps each YAML node in a recursive conversion wrapper.
-        for (YAML::const_iterator it = decl_config_.begin();
-             it != decl_config_.end(); ++it)
+        for (YAML::const_iterator it = decl_config_.node.begin();
+             it != decl_config_.node.end(); ++it)
         {
             const std::string name = it->first.as<std::string>();
             const YAML::Node &value = it->second;
@@ -57,6 +57,7 @@ public:
                 {chimera::util::END_OF_SEQUENCE, &ClangWrapper::last},
                 {"name", &ClangWrapper::name},
                 {"mangled_name", &ClangWrapper::mangledName},
+                {"header_path", &ClangWrapper::headerPath},
                 {"qualified_name", &ClangWrapper::qualifiedName},
                 {"namespace_scope", &ClangWrapper::namespaceScope},
                 {"namespace_scope?",
@@ -78,6 +79,14 @@ public:
 
     virtual ~ClangWrapper() = default;
 
+    /**
+     * Gets the wrapped declaration.
+     */
+    const T *getDecl() const
+    {
+        return decl_;
+    }
+
     ::mstch::node last()
     {
         return last_;
@@ -85,18 +94,12 @@ public:
 
     virtual ::std::string nameAsString()
     {
-        if (const YAML::Node node = decl_config_["name"])
-        {
-            // Convert a `null` to an empty string.
-            // This helps users semantically mark names that should be
-            // omitted in their configuration files, although we will
-            // actually ignore any name that evaluates to an empty string.
-            if (node.IsNull())
-            {
-                return std::string{""};
-            }
-            return node.as<std::string>();
-        }
+        // A `null` name has already been converted to an empty string.
+        // This helps users semantically mark names that should be omitted
+        // in their configuration files, although we will actually ignore
+        // any name that evaluates to an empty string.
+        if (decl_config_.name)
+            return *decl_config_.name;
 
         return decl_->getNameAsString();
     }
@@ -108,12 +111,18 @@ public:
 
     virtual ::mstch::node mangledName()
     {
-        if (const YAML::Node node = decl_config_["mangled_name"])
-            return node.as<std::string>();
+        if (decl_config_.mangled_name)
+            return *decl_config_.mangled_name;
 
         return chimera::util::constructMangledName(decl_);
     }
 
+    ::mstch::node headerPath()
+    {
+        return config_.GetHeaderPath(
+            decl_, ::boost::get<std::string>(mangledName()));
+    }
+
     virtual ::mstch::node namespaceScope()
     {
         // Default is empty, overriden in subclasses.
@@ -137,8 +146,8 @@ public:
 
     virtual ::mstch::node qualifiedName()
     {
-        if (const YAML::Node node = decl_config_["qualified_name"])
-            return node.as<std::string>();
+        if (decl_config_.qualified_name)
+            return *decl_config_.qualified_name;
 
         return decl_->getQualifiedNameAsString();
     }
@@ -187,7 +196,7 @@ public:
 protected:
     const ::chimera::CompiledConfiguration &config_;
     const T *decl_;
-    const YAML::Node &decl_config_;
+    const ::chimera::DeclarationConfig &decl_config_;
     bool last_;
 
     template <typename Derived, ::mstch::node (Derived::*Func)()>
@@ -235,6 +244,34 @@ public:
     ::mstch::node fields();
     ::mstch::node staticFields();
 
+    /**
+     * Returns the parts in which the remaining instance methods of this
+     * class are registered, if it is split across several files.
+     */
+    ::mstch::node parts();
+
+    /**
+     * Splits the instance methods into consecutive ranges of at most the
+     * given number of overloads.  A method with more overloads than this
+     * forms a range on its own.
+     */
+    std::vector<std::pair<std::size_t, std::size_t>> splitMethods(
+        std::size_t max_overloads) const;
+
+    /**
+     * Restricts the instance methods of this class to the given range and
+     * sets the number of parts in which the remaining methods are registered.
+     */
+    void setMethodRange(std::size_t begin, std::size_t end,
+                        std::size_t part_count = 0);
+
+    /**
+     * Creates a wrapper of the same class that is restricted to the given
+     * range of instance methods.
+     */
+    std::shared_ptr<CXXRecord> createPart(std::size_t begin,
+                                          std::size_t end) const;
+
 protected:
     const std::set<const clang::CXXRecordDecl *> *available_decls_;
 
@@ -245,6 +282,16 @@ private:
      * names.
      */
     ::mstch::node methodsInternal() const;
+
+    /**
+     * Returns all the instance methods, regardless of the method range.
+     */
+    ::mstch::array instanceMethods() const;
+
+    mutable boost::optional<::mstch::array> methods_;
+    std::size_t method_begin_;
+    std::size_t method_end_;
+    std::size_t part_count_;
 };
 
 class Enum : public ClangWrapper<clang::EnumDecl>
@@ -0,0 +1,128 @@
+#ifndef __CHIMERA_OUTPUT_WRITER_H__
+#define __CHIMERA_OUTPUT_WRITER_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chimera
+{
+
+/**
+ * Writes rendered bindings to the output directory.
+ *
+ * By default, files are written as soon as they are rendered.  With a write
+ * queue, rendered files are handed to a background thread that writes them
+ * while rendering continues, and Flush() waits for it to finish.
+ *
+ * Files whose content has not changed are left untouched, so that their
+ * modification times do not trigger rebuilds.  Changed files are replaced
+ * atomically by renaming a temporary file over them.
+ *
+ * The files written by a run can be recorded in a manifest, which is used by
+ * the next run to remove the files that are no longer generated.
+ *
+ * Files may be written by several threads at once.
+ */
+class OutputWriter
+{
+public:
+    OutputWriter();
+    ~OutputWriter();
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+    /**
+     * Sets the number of rendered files that may wait to be written by a
+     * background thread before Write() blocks.  If zero, files are written by
+     * the thread that renders them.
+     */
+    void SetQueueSize(std::size_t size);
+
+    /**
+     * Writes the content of a rendered file, or queues it for the background
+     * thread.  Returns false if the file could not be written.  Failures of
+     * queued files are reported by Flush().
+     */
+    bool Write(const std::string &path, const std::string &content);
+
+    /**
+     * Waits for the queued files to be written.
+     * Throws a std::runtime_error if a queued file could not be written.
+     */
+    void Flush();
+
+    /**
+     * Returns the number of files that were created or replaced.
+     */
+    std::size_t GetNumWritten() const;
+
+    /**
+     * Returns the number of files that were left untouched because their
+     * content was unchanged.
+     */
+    std::size_t GetNumUnchanged() const;
+
+    /**
+     * Returns the paths of the files that were created or replaced.
+     */
+    const std::vector<std::string> &GetChangedPaths() const;
+
+    /**
+     * Returns the paths of all files written by this run, including the
+     * files that were kept.
+     */
+    const std::vector<std::string> &GetPaths() const;
+
+    /**
+     * Records a file that was written by another process as part of this
+     * run, so that it is recorded in the manifest rather than removed.
+     */
+    void Keep(const std::string &path);
+
+    /**
+     * Removes the files that are listed in the manifest of a previous run but
+     * were not written by this run, then replaces the manifest with the files
+     * written by this run.  Paths in the manifest are relative to the
+     * directory of the manifest.
+     *
+     * Returns the paths of the removed files.
+     */
+    std::vector<std::string> UpdateManifest(const std::string &manifest_path);
+
+private:
+    void Enqueue(std::unique_lock<std::mutex> &lock, const std::string &path,
+                 const std::string &content);
+    void WriteQueue();
+    std::error_code WriteFile(const std::string &path,
+                              const std::string &content);
+    std::error_code ReplaceFile(const std::string &path,
+                                const std::string &content, bool &changed);
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> paths_;
+    std::vector<std::string> changed_paths_;
+    std::size_t num_written_;
+    std::size_t num_unchanged_;
+
+    // Files waiting for the background thread, which records the first
+    // failure to be reported by Flush().
+    std::size_t queue_size_;
+    std::deque<std::pair<std::string, std::string>> queue_;
+    std::condition_variable queue_filled_;
+    std::condition_variable queue_drained_;
+    bool writing_;
+    bool stopping_;
+    std::string error_;
+    std::thread thread_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_OUTPUT_WRITER_H__
@@ -0,0 +1,69 @@
+#ifndef __CHIMERA_PRECOMPILED_HEADER_H__
+#define __CHIMERA_PRECOMPILED_HEADER_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <clang/Tooling/CompilationDatabase.h>
+
+namespace chimera
+{
+
+/**
+ * A cache of precompiled headers for a set of heavy prefix includes.
+ *
+ * The prefix includes are written to a generated header, which is compiled
+ * into a precompiled header with the compile command of a source on the
+ * first run.  Precompiled headers are keyed by a hash of the compile command,
+ * the prefix includes and the clang version, and are reused by later runs
+ * until the content of any of the files they were built from changes.
+ */
+class PrecompiledHeaderCache
+{
+public:
+    /**
+     * Creates a cache in a directory for the given prefix includes, which
+     * are either paths of existing files or names as they would be written
+     * in an angle-bracket #include directive.
+     */
+    PrecompiledHeaderCache(const std::string &directory,
+                           const std::vector<std::string> &includes);
+
+    /**
+     * Returns the path of an up-to-date precompiled header for a compile
+     * command, building it first if necessary.  The arguments are inserted
+     * at the beginning of the compile command, and the language is used to
+     * compile the prefix header, e.g. "c++".
+     *
+     * Returns an empty string if the precompiled header could not be built.
+     */
+    std::string Get(const clang::tooling::CompileCommand &command,
+                    const std::vector<std::string> &arguments,
+                    const std::string &language);
+
+    /**
+     * Returns the files that the precompiled headers returned by Get() were
+     * built from.
+     */
+    const std::vector<std::string> &GetInputFiles() const;
+
+    /**
+     * Returns the number of precompiled headers that were built, rather than
+     * reused from a previous run.
+     */
+    std::size_t GetNumBuilt() const;
+
+private:
+    bool IsUpToDate(const std::string &pch_path);
+    bool Build(const clang::tooling::CompileCommand &command,
+               const std::string &header_path, const std::string &pch_path);
+
+    std::string directory_;
+    std::vector<std::string> includes_;
+    std::vector<std::string> input_files_;
+    std::size_t num_built_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_PRECOMPILED_HEADER_H__
@@ -0,0 +1,34 @@
+#ifndef __CHIMERA_SERVER_H__
+#define __CHIMERA_SERVER_H__
+
+#include <functional>
+#include <string>
+
+namespace chimera
+{
+
+/**
+ * Listens on a local UNIX socket and answers each request with the response
+ * of a handler.  A request and its response are each sent over their own
+ * connection, and a request is terminated by a newline.  The request "stop"
+ * stops the server.
+ *
+ * The socket of a previous server that was not shut down is replaced.
+ * Throws a std::runtime_error if the path is taken by another file or by a
+ * server that still runs, or if the socket cannot be created.
+ */
+void serve(const std::string &socket_path,
+           const std::function<std::string(const std::string &)> &handler);
+
+/**
+ * Sends a request to a server on a local UNIX socket and receives its
+ * response.  Returns false if no server is listening on the socket, or if
+ * the socket cannot be connected to for any other reason, such as a path
+ * that is too long for a socket address.
+ */
+bool request(const std::string &socket_path, const std::string &request,
+             std::string &response);
+
+} // namespace chimera
+
+#endif // __CHIMERA_SERVER_H__
@@ -0,0 +1,72 @@
+#ifndef __CHIMERA_STATISTICS_H__
+#define __CHIMERA_STATISTICS_H__
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace chimera
+{
+
+/**
+ * Named counters that are collected over the course of a chimera run.
+ *
+ * Counters are reported in the order in which they were first recorded.
+ */
+class Statistics
+{
+public:
+    Statistics() = default;
+    Statistics(const Statistics &) = delete;
+    Statistics &operator=(const Statistics &) = delete;
+
+    /**
+     * Adds a value to a named counter, creating the counter if necessary.
+     */
+    void Add(const std::string &name, std::size_t value = 1);
+
+    /**
+     * Sets a named counter to a value, creating the counter if necessary.
+     */
+    void Set(const std::string &name, std::size_t value);
+
+    /**
+     * Gets the value of a named counter, or zero if it was never recorded.
+     */
+    std::size_t Get(const std::string &name) const;
+
+    /**
+     * Prints all counters as a human-readable report.
+     */
+    void Print(std::ostream &os) const;
+
+private:
+    std::size_t &Find(const std::string &name);
+
+    mutable std::mutex mutex_;
+    std::vector<std::pair<std::string, std::size_t>> counters_;
+};
+
+/**
+ * Returns the current resident set size of this process in bytes, or zero if
+ * it cannot be determined on this platform.
+ */
+std::size_t getResidentMemory();
+
+/**
+ * Returns the peak resident set size of this process in bytes, or zero if it
+ * cannot be determined on this platform.
+ */
+std::size_t getPeakResidentMemory();
+
+/**
+ * Returns freed heap memory to the operating system where this is supported.
+ */
+void releaseFreeMemory();
+
+} // namespace chimera
+
+#endif // __CHIMERA_STATISTICS_H__
@@ -0,0 +1,98 @@
+#ifndef __CHIMERA_THREAD_POOL_H__
+#define __CHIMERA_THREAD_POOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chimera
+{
+
+/**
+ * Runs independent tasks on a number of threads, largest first.
+ *
+ * The threads start with the first task, and run the tasks while more of
+ * them are added.  Only a bounded number of tasks wait to be started, and
+ * adding a task blocks while that many are waiting, so that the tasks are
+ * not collected faster than they are run.  Each thread takes the largest
+ * task that is waiting, which keeps the biggest tasks from finishing last.
+ * Ties are broken by the order in which the tasks were added.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Creates a pool that runs tasks on the given number of threads.  A pool
+     * of one thread starts none, and runs the tasks on the thread that adds
+     * them or waits for them instead.
+     *
+     * At most the given number of tasks wait to be started.  If zero, four
+     * tasks per thread may wait.
+     */
+    explicit ThreadPool(unsigned num_threads, std::size_t max_pending = 0);
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Stops the threads.  Tasks that were not started yet are skipped.
+     */
+    ~ThreadPool();
+
+    /**
+     * Adds a task with an estimated cost, which is used to order the tasks.
+     * Blocks while the maximum number of tasks are waiting to be started,
+     * or, without threads, runs the largest of them first.
+     */
+    void Add(std::size_t cost, std::function<void()> task);
+
+    /**
+     * Waits for all tasks that were added to finish.
+     *
+     * If any task throws, the tasks that were not started yet are skipped,
+     * as are the tasks that are added until this returns, and the exception
+     * of the earliest added task that threw is rethrown.
+     */
+    void Wait();
+
+    /**
+     * Returns the number of threads that tasks are run on.
+     */
+    unsigned GetNumThreads() const;
+
+private:
+    struct Task
+    {
+        std::size_t cost;
+        std::size_t index;
+        std::function<void()> run;
+    };
+
+    Task TakeTask();
+    void RunTask(Task &task, std::unique_lock<std::mutex> &lock);
+    void Work();
+
+    unsigned num_threads_;
+    std::size_t max_pending_;
+    std::vector<std::thread> threads_;
+
+    // Tasks that wait to be started, as a heap with the largest on top, and
+    // the state of the tasks that were started.  The progress is signaled
+    // whenever a task is started or finishes.
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::condition_variable progress_;
+    std::vector<Task> pending_;
+    std::size_t num_added_;
+    std::size_t num_running_;
+    std::exception_ptr error_;
+    std::size_t error_index_;
+    bool stopping_;
+};
+
+} // namespace chimera
+
+#endif // __CHIMERA_THREAD_POOL_H__
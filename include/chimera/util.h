@@ -1,11 +1,13 @@
 #ifndef __CHIMERA_UTIL_H__
 #define __CHIMERA_UTIL_H__
 
+#include <cstdint>
 #include <set>
 #include <boost/optional.hpp>
 #include <clang/AST/ASTContext.h>
 #include <clang/AST/Type.h>
 #include <clang/Frontend/CompilerInstance.h>
+#include <clang/Tooling/CompilationDatabase.h>
 #include <mstch/mstch.hpp>
 #include <yaml-cpp/yaml.h>
 
@@ -215,11 +217,36 @@ std::string constructBindingName(const clang::CXXRecordDecl *decl);
  */
 std::string constructMangledName(const clang::NamedDecl *decl);
 
+/**
+ * Hit and miss counts of the memoized type predicates for an AST context.
+ */
+struct TypeCacheStatistics
+{
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+};
+
+/**
+ * Returns the hit and miss counts of the memoized type predicates
+ * (containsIncompleteType, isAssignable and isCopyable) for an AST context.
+ */
+TypeCacheStatistics getTypeCacheStatistics(const clang::ASTContext &context);
+
+/**
+ * Discards the memoized type predicate results for an AST context.
+ *
+ * This must be called before the AST context is destroyed, since results are
+ * keyed on pointers into the AST.
+ */
+void clearTypeCaches(const clang::ASTContext &context);
+
 /**
  * Returns whether a type contains incomplete argument types.
  *
  * This is useful in cases where we need RTTI information about all arguments,
  * including references and pointers.
+ *
+ * Results are memoized per canonical type.
  */
 bool containsIncompleteType(clang::Sema &sema, clang::QualType qual_type);
 
@@ -243,21 +270,25 @@ bool containsNonCopyableType(const clang::FunctionDecl *decl);
 
 /**
  * Determine if a CXXRecordDecl is referring to a type that could be assigned.
+ * Results are memoized per declaration.
  */
 bool isAssignable(const clang::CXXRecordDecl *decl);
 
 /**
  * Determine if a QualType is referring to a type that could be assigned.
+ * Results are memoized per canonical type.
  */
 bool isAssignable(clang::ASTContext &context, clang::QualType qual_type);
 
 /**
  * Determine if a CXXRecordDecl is referring to a class that is copyable.
+ * Results are memoized per declaration.
  */
 bool isCopyable(const clang::CXXRecordDecl *decl);
 
 /**
  * Determine if a QualType is referring to a type that is copyable.
+ * Results are memoized per canonical type.
  */
 bool isCopyable(clang::ASTContext &context, clang::QualType qual_type);
 
@@ -339,6 +370,59 @@ boost::optional<std::string> getOperatorName(
  */
 std::string getBuiltinTypeName(const std::string &type_name);
 
+/**
+ * Returns a 64-bit FNV-1a hash of a string.
+ *
+ * Unlike std::hash, this is stable across runs, platforms and compilers, so
+ * it can be used to derive names and partitions that must be reproducible.
+ */
+std::uint64_t stableHash(const std::string &str);
+
+/**
+ * Splits items with estimated costs into at most the given number of
+ * partitions of similar total cost, using the longest-processing-time-first
+ * heuristic.  Each partition lists the indices of its items in order, and
+ * none of the partitions is empty.
+ */
+std::vector<std::vector<std::size_t>> partitionByCost(
+    const std::vector<std::size_t> &costs, std::size_t count);
+
+/**
+ * De-conflicts paths that are longer than 255 characters.
+ * (This is the maximum path length on many operating systems.)
+ *
+ * Long paths are truncated and suffixed with a hash of the full filename
+ * (without its extension), so the shortened name of a binding only depends
+ * on its own name and is shared between its header and source files.
+ */
+std::string sanitizePath(const std::string &path);
+
+/**
+ * Returns the stable hash of the content of a file in hexadecimal, or an
+ * empty string if the file cannot be read.
+ */
+std::string hashFileContent(const std::string &path);
+
+/**
+ * Records the paths and content hashes of a list of files.
+ * Returns false if the record could not be written.
+ */
+bool writeFileHashes(const std::string &path,
+                     const std::vector<std::string> &files);
+
+/**
+ * Reads the paths of a list of files recorded by writeFileHashes().
+ * Returns false if the record cannot be read or any of the files has changed
+ * since it was recorded.
+ */
+bool readFileHashes(const std::string &path, std::vector<std::string> &files);
+
+/**
+ * Returns whether an argument of a compile command is its input file.
+ */
+bool isInputArgument(const std::string &argument,
+                     const clang::tooling::CompileCommand &command);
+
 /**
  * Trims from end of string (right)
  */
@@ -0,0 +1,13 @@
+#include "chimera/arena.h"
+
+void *chimera::Arena::Allocate(std::size_t size, std::size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocator_.Allocate(size, alignment);
+}
+
+std::size_t chimera::Arena::GetBytesAllocated() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocator_.getBytesAllocated();
+}
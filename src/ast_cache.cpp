@@ -0,0 +1,108 @@
+#include "chimera/ast_cache.h"
+#include "chimera/util.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <clang/Basic/Version.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+using namespace clang::tooling;
+
+chimera::ASTCache::ASTCache(const std::string &directory)
+  : directory_(directory), num_found_(0)
+{
+    // Do nothing.
+}
+
+bool chimera::ASTCache::Find(const CompileCommand &command,
+                             const std::vector<std::string> &arguments,
+                             std::string &ast_path)
+{
+    // Ignore the output and dependency file arguments, which do not affect
+    // the parsed translation unit.
+    CommandLineArguments command_line = command.CommandLine;
+    command_line
+        = getClangStripOutputAdjuster()(command_line, command.Filename);
+    command_line = getClangStripDependencyFileAdjuster()(command_line,
+                                                         command.Filename);
+
+    // Key the AST by everything that affects its content except for the
+    // content of the files that it is parsed from, which is checked
+    // separately so that the key is known before the source is parsed.
+    std::stringstream key;
+    key << CHIMERA_MAJOR_VERSION << "." << CHIMERA_MINOR_VERSION << "."
+        << CHIMERA_PATCH_VERSION << "\n"
+        << clang::getClangFullVersion() << "\n"
+        << command.Directory << "\n"
+        << command.Filename << "\n";
+    for (const std::string &argument : arguments)
+        key << argument << "\n";
+    for (const std::string &argument : command_line)
+        if (!chimera::util::isInputArgument(argument, command))
+            key << argument << "\n";
+
+    // Name the AST after its source so that the cache can be inspected.
+    std::stringstream filename;
+    filename << llvm::sys::path::filename(command.Filename).str() << "-"
+             << std::hex << std::setfill('0') << std::setw(16)
+             << chimera::util::stableHash(key.str()) << ".ast";
+    llvm::SmallString<256> path(directory_);
+    llvm::sys::path::append(path, filename.str());
+    llvm::sys::fs::make_absolute(path);
+    ast_path = path.str();
+
+    // The AST can be reused if none of the files that it was parsed from
+    // have changed.
+    std::vector<std::string> input_files;
+    if (llvm::sys::fs::exists(ast_path)
+        && chimera::util::readFileHashes(ast_path + ".inputs", input_files))
+    {
+        input_files_.insert(input_files_.end(), input_files.begin(),
+                            input_files.end());
+        ++num_found_;
+        return true;
+    }
+
+    llvm::sys::fs::create_directories(directory_);
+    llvm::sys::fs::remove(ast_path);
+    llvm::sys::fs::remove(ast_path + ".inputs");
+    return false;
+}
+
+void chimera::ASTCache::AddSavedAST(const std::string &ast_path,
+                                    const std::vector<std::string> &input_files)
+{
+    saved_.emplace_back(ast_path, input_files);
+}
+
+void chimera::ASTCache::Commit()
+{
+    for (const auto &saved : saved_)
+    {
+        // The AST is only written once its source was parsed successfully.
+        if (!llvm::sys::fs::exists(saved.first))
+            continue;
+
+        if (!chimera::util::writeFileHashes(saved.first + ".inputs",
+                                            saved.second))
+        {
+            std::cerr << "Warning: Unable to record the inputs of AST '"
+                      << saved.first << "'." << std::endl;
+        }
+    }
+    saved_.clear();
+}
+
+const std::vector<std::string> &chimera::ASTCache::GetInputFiles() const
+{
+    return input_files_;
+}
+
+std::size_t chimera::ASTCache::GetNumFound() const
+{
+    return num_found_;
+}
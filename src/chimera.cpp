@@ -3,14 +3,20 @@
  */
 #include "chimera/chimera.h"
 #include "chimera/configuration.h"
-#include "chimera/frontend_action.h"
+#include "chimera/generator.h"
+#include "chimera/server.h"
+#include "chimera/util.h"
 
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
-#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <vector>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
 
 #define STR_DETAIL(x) #x
 #define STR(x) STR_DETAIL(x)
@@ -26,9 +32,12 @@ namespace chimera
 // only ones displayed.
 static cl::OptionCategory ChimeraCategory("Chimera options");
 
-// Option for specifying binding type by name.
-static cl::opt<std::string> BindingName(
-    "b", cl::cat(ChimeraCategory), cl::desc("Specify binding definition name"),
+// Option for specifying binding types by name.
+static cl::list<std::string> BindingNames(
+    "b", cl::cat(ChimeraCategory), cl::CommaSeparated,
+    cl::desc("Specify one or more binding definition names, each of which is "
+             "generated into a subdirectory named after it if there are "
+             "several"),
     cl::value_desc("binding"));
 
 // Option for specifying output binding filename.
@@ -54,6 +63,15 @@ static cl::opt<std::string> ConfigFilename(
     cl::desc("Specify YAML configuration filename"),
     cl::value_desc("filename"));
 
+// Option for generating several modules from one parse of the sources.
+static cl::list<std::string> ModuleSpecs(
+    "module", cl::cat(ChimeraCategory),
+    cl::desc("Generate a module from the same parse as the others, specified "
+             "as comma-separated 'binding=', 'name=', 'output=', 'config=', "
+             "'namespace=' and 'depfile=' options that default to -b, -m, "
+             "-o, -c, -n and -depfile"),
+    cl::value_desc("spec"));
+
 // Option for switching from C++ to C source.
 static cl::opt<bool> UseCMode(
     "use-c", cl::cat(ChimeraCategory),
@@ -75,13 +93,216 @@ static cl::opt<bool> Strict(
     "strict", cl::cat(ChimeraCategory),
     cl::desc("Treat unresolvable configuration as errors"));
 
+// Option for exporting the binding dependency graph.
+static cl::opt<std::string> DependencyGraphPath(
+    "dependency-graph", cl::cat(ChimeraCategory),
+    cl::desc("Write the binding dependency graph in DOT format"),
+    cl::value_desc("filename"));
+
+// Option for releasing the AST before rendering the bindings.
+static cl::opt<bool> ReleaseAST(
+    "release-ast", cl::cat(ChimeraCategory),
+    cl::desc("Free the compiler AST before rendering the bindings, and report "
+             "resident memory before and after release"));
+
+// Option for merging binding sources into unity translation units.
+static cl::opt<unsigned> UnityFileCount(
+    "unity-files", cl::cat(ChimeraCategory),
+    cl::desc("Merge the binding sources into the given number of unity "
+             "translation units, balanced by estimated compilation cost"),
+    cl::value_desc("count"), cl::init(0));
+
+// Option for rendering the bindings on several threads.
+static cl::opt<unsigned> Jobs(
+    "j", cl::cat(ChimeraCategory),
+    cl::desc("Render and write the bindings on the given number of threads"),
+    cl::value_desc("count"), cl::init(0));
+
+// Option for writing the bindings on a background thread.
+static cl::opt<unsigned> WriteQueueSize(
+    "write-queue", cl::cat(ChimeraCategory),
+    cl::desc("Write the bindings on a background thread, with up to the "
+             "given number of rendered files waiting to be written"),
+    cl::value_desc("count"), cl::init(0));
+
+// Option for splitting large classes across several binding sources.
+static cl::opt<unsigned> ClassSplitThreshold(
+    "split-class-threshold", cl::cat(ChimeraCategory),
+    cl::desc("Split the binding of classes with more instance method "
+             "overloads than this across several source files"),
+    cl::value_desc("count"), cl::init(0));
+
+// Option for including only the headers that each binding needs.
+static cl::opt<bool> MinimalIncludes(
+    "minimal-includes", cl::cat(ChimeraCategory),
+    cl::desc("Include only the headers that declare each binding and the "
+             "types it uses, instead of every source file"));
+
+// Option for rendering a prefix header for precompilation.
+static cl::opt<bool> PrefixHeader(
+    "prefix-header", cl::cat(ChimeraCategory),
+    cl::desc("Render a prefix header with the binding framework and common "
+             "sources, suitable for use as a precompiled header"));
+
+// Option for listing the generated files without writing them.
+static cl::opt<bool> ListOutputs(
+    "list-outputs", cl::cat(ChimeraCategory),
+    cl::desc("Only list the files that would be generated, without "
+             "rendering or writing them"));
+
+// Options for writing a depfile of the files the bindings depend on.
+static cl::opt<std::string> DepfilePath(
+    "depfile", cl::cat(ChimeraCategory),
+    cl::desc("Write a Makefile-style depfile listing every file that the "
+             "generated bindings depend on"),
+    cl::value_desc("filename"));
+static cl::opt<std::string> DepfileTarget(
+    "depfile-target", cl::cat(ChimeraCategory),
+    cl::desc("Specify the target of the depfile (defaults to the top-level "
+             "source file)"),
+    cl::value_desc("target"));
+
+// Option for the layout of the generated bindings.
+static cl::opt<chimera::OutputLayout> Layout(
+    "output-layout", cl::cat(ChimeraCategory),
+    cl::desc("Specify the layout of the generated bindings"),
+    cl::values(clEnumValN(chimera::OutputLayout::Flat, "flat",
+                          "All bindings in the output directory (default)"),
+               clEnumValN(chimera::OutputLayout::Hash, "hash",
+                          "Bindings in 256 hashed subdirectories"),
+               clEnumValN(chimera::OutputLayout::Namespace, "namespace",
+                          "Bindings in subdirectories named after their "
+                          "namespaces")),
+    cl::init(chimera::OutputLayout::Flat));
+
+// Option for caching the parsed translation units.
+static cl::opt<std::string> ASTCachePath(
+    "ast-cache", cl::cat(ChimeraCategory),
+    cl::desc("Save the parsed sources in the given directory, and load them "
+             "instead of parsing again in later runs where nothing that they "
+             "were parsed from has changed"),
+    cl::value_desc("directory"));
+
+// Options for precompiling heavy includes into a cached precompiled header.
+static cl::opt<std::string> PCHCachePath(
+    "pch-cache", cl::cat(ChimeraCategory),
+    cl::desc("Precompile the -pch-include headers into a precompiled header "
+             "that is cached in the given directory and reused by later runs"),
+    cl::value_desc("directory"));
+static cl::list<std::string> PCHIncludes(
+    "pch-include", cl::cat(ChimeraCategory),
+    cl::desc("Specify a header to include through the precompiled header "
+             "before each source"),
+    cl::value_desc("header"));
+
+// Options for splitting the rendering of the bindings across processes.
+static cl::opt<std::string> Shard(
+    "shard", cl::cat(ChimeraCategory),
+    cl::desc("Only render the bindings of the given shard out of a number "
+             "of shards, and record them for -merge-shards"),
+    cl::value_desc("index/count"));
+static cl::opt<unsigned> MergeShardCount(
+    "merge-shards", cl::cat(ChimeraCategory),
+    cl::desc("Combine the outputs of the given number of shards without "
+             "parsing the sources, and list them"),
+    cl::value_desc("count"), cl::init(0));
+
+// Options for keeping the sources parsed in a server between runs.
+static cl::opt<std::string> ServePath(
+    "serve", cl::cat(ChimeraCategory),
+    cl::desc("Keep the sources parsed, and generate the bindings whenever a "
+             "client connects to the given local socket"),
+    cl::value_desc("socket"));
+static cl::opt<std::string> ConnectPath(
+    "connect", cl::cat(ChimeraCategory),
+    cl::desc("Let the server on the given local socket generate the bindings "
+             "if one is listening"),
+    cl::value_desc("socket"));
+
+// Option for regenerating the bindings whenever their inputs change.
+static cl::opt<bool> Watch(
+    "watch", cl::cat(ChimeraCategory),
+    cl::desc("Keep the sources parsed, and regenerate the bindings whenever "
+             "any of the files that they depend on changes"));
+
+// Option for printing run statistics.
+static cl::opt<bool> PrintStatistics(
+    "print-run-stats", cl::cat(ChimeraCategory),
+    cl::desc("Print statistics about the run to stderr"));
+
 // Add a footer to the help text.
 static cl::extrahelp MoreHelp(
     "\n"
     "Chimera is a tool to convert C++ headers into Boost.Python bindings.\n"
     "\n");
 
-int run(int argc, const char **argv)
+/**
+ * Returns a key that identifies the arguments and the executable of this run,
+ * leaving out the options that select the socket of a server.  A server only
+ * answers clients whose key equals its own.
+ */
+static std::string getServerKey(int argc, const char **argv)
+{
+    std::stringstream Key;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string Arg = argv[i];
+        const std::string Name = Arg.substr(0, Arg.find('='));
+        if (Name == "-serve" || Name == "--serve" || Name == "-connect"
+            || Name == "--connect")
+        {
+            // Skip the socket path if it is given as a separate argument.
+            if (Name == Arg)
+                ++i;
+            continue;
+        }
+        Key << Arg << '\0';
+    }
+
+    // A rebuilt executable may generate other bindings from the same
+    // arguments.
+    static int Anchor;
+    const std::string Executable
+        = sys::fs::getMainExecutable(argv[0], &Anchor);
+    sys::fs::file_status Status;
+    if (!sys::fs::status(Executable, Status))
+        Key << Executable << '\0'
+            << Status.getLastModificationTime().time_since_epoch().count();
+
+    std::stringstream Hash;
+    Hash << std::hex << chimera::util::stableHash(Key.str());
+    return Hash.str();
+}
+
+/**
+ * Prints the response of a server as if the bindings were generated by this
+ * process.  Returns the exit code of the server's run.
+ */
+static int printResponse(const std::string &Response)
+{
+    int result = 0;
+    std::stringstream Lines(Response);
+    std::string Line;
+    while (std::getline(Lines, Line))
+    {
+        if (Line.compare(0, 4, "out ") == 0)
+            std::cout << Line.substr(4) << "\n";
+        else if (Line.compare(0, 8, "changed ") == 0)
+            std::cerr << "Updated " << Line.substr(8) << "\n";
+        else if (Line.compare(0, 6, "error ") == 0)
+        {
+            std::cerr << Line.substr(6) << "\n";
+            result = 1;
+        }
+    }
+    return result;
+}
+
+/**
+ * Generates the bindings from the command-line arguments.  Returns the exit
+ * code of the run.
+ */
+static int generate(int argc, const char **argv)
 {
     // Print custom output for `--version` option
     for (int i = 1; i < argc; ++i)
@@ -98,56 +319,112 @@ int run(int argc, const char **argv)
     // Create parser that handles clang options.
     CommonOptionsParser OptionsParser(argc, argv, ChimeraCategory);
 
-    // Create a new configuration that will be used for the run.
-    chimera::Configuration Config;
-
-    // Parse the YAML configuration file if it exists, otherwise initialize it
-    // to an empty node.
-    if (!ConfigFilename.empty())
-        Config.LoadFile(ConfigFilename);
+    // If a server is listening, let it generate the bindings instead, unless
+    // it was started with other arguments or another executable.
+    const std::string ServerKey = getServerKey(argc, argv);
+    if (!ConnectPath.empty())
+    {
+        std::string Response;
+        if (chimera::request(ConnectPath, "generate " + ServerKey, Response))
+        {
+            if (Response != "mismatch\n")
+                return printResponse(Response);
+            std::cerr << "The server on '" << ConnectPath
+                      << "' was started with other arguments or another "
+                      << "chimera, so the bindings are generated locally."
+                      << std::endl;
+        }
+    }
 
-    // If a binding definition was specified, set configuration to use it.
-    if (!BindingName.empty())
-        Config.SetBindingName(BindingName);
+    // Collect the command-line options for the generator.
+    chimera::GeneratorOptions Options;
+    Options.binding_names.assign(BindingNames.begin(), BindingNames.end());
+    Options.output_path = OutputPath;
+    Options.module_name = OutputModuleName;
+    Options.namespace_names.assign(NamespaceNames.begin(),
+                                   NamespaceNames.end());
+    Options.config_filename = ConfigFilename;
+    Options.use_c_mode = UseCMode;
+    Options.suppress_docs = SuppressDocs;
+    Options.suppress_sources = SuppressSources;
+    Options.strict = Strict;
+    Options.dependency_graph_path = DependencyGraphPath;
+    Options.release_ast = ReleaseAST;
+    Options.unity_file_count = UnityFileCount;
+    Options.jobs = Jobs;
+    Options.write_queue_size = WriteQueueSize;
+    Options.class_split_threshold = ClassSplitThreshold;
+    Options.minimal_includes = MinimalIncludes;
+    Options.prefix_header = PrefixHeader;
+    Options.list_outputs = ListOutputs;
+    Options.depfile_path = DepfilePath;
+    Options.depfile_target = DepfileTarget;
+    Options.output_layout = Layout;
+    Options.ast_cache_path = ASTCachePath;
+    Options.pch_cache_path = PCHCachePath;
+    Options.pch_includes.assign(PCHIncludes.begin(), PCHIncludes.end());
+    for (const std::string &Spec : ModuleSpecs)
+        Options.modules.push_back(chimera::parseModuleSpec(Spec));
+    if (!Shard.empty())
+        chimera::parseShardSpec(Shard, Options.shard_index,
+                                Options.shard_count);
 
-    // If an output path was specified, set configuration to use it.
-    if (!OutputPath.empty())
-        Config.SetOutputPath(OutputPath);
+    chimera::Generator BindingGenerator(OptionsParser.getCompilations(),
+                                        OptionsParser.getSourcePathList(),
+                                        Options);
 
-    // If a top-level binding file was specified, set configuration to use it.
-    if (!OutputModuleName.empty())
-        Config.SetOutputModuleName(OutputModuleName);
+    // If requested, keep the sources parsed and serve clients instead.
+    if (!ServePath.empty())
+    {
+        BindingGenerator.Serve(ServePath, ServerKey);
+        return 0;
+    }
 
-    // Add top-level namespaces to the configuration.
-    if (NamespaceNames.size())
-        for (const std::string &name : NamespaceNames)
-            Config.AddInputNamespaceName(name);
+    // If requested, keep the sources parsed and regenerate on changes.
+    if (Watch)
+        BindingGenerator.Watch();
 
-    // Add compilation source paths to the configuration.
-    // These will be made available to templates.
-    if (!SuppressSources)
-        for (const std::string &path : OptionsParser.getSourcePathList())
-            Config.AddSourcePath(path);
+    // Create a new configuration for each module that will be generated.
+    const std::vector<std::unique_ptr<chimera::Configuration>> Configs
+        = BindingGenerator.CreateConfigurations();
 
-    // If strict option is on, treats unresolvable configuration as errors.
-    if (Strict)
-        Config.SetStrict(true);
+    // If requested, combine the outputs of the shards of a previous run.
+    if (MergeShardCount > 0)
+    {
+        BindingGenerator.Merge(Configs, MergeShardCount);
+        return 0;
+    }
 
-    // Create tool that uses the command-line options.
-    ClangTool Tool(OptionsParser.getCompilations(),
-                   OptionsParser.getSourcePathList());
+    const int result = BindingGenerator.Run(Configs);
 
-    // Add or suppress clang documentation flag as specified.
-    Tool.appendArgumentsAdjuster(getInsertArgumentAdjuster(
-        SuppressDocs ? "-Wno-documentation" : "-Wdocumentation",
-        ArgumentInsertPosition::BEGIN));
+    // Statistics go to stderr, since stdout lists the generated files.
+    if (PrintStatistics)
+    {
+        for (const auto &Config : Configs)
+        {
+            if (Configs.size() > 1)
+                std::cerr << "Module '" << Config->GetOutputModuleName()
+                          << "':\n";
+            Config->GetStatistics().Print(std::cerr);
+        }
+    }
 
-    // Add the appropriate C/C++ language flag.
-    Tool.appendArgumentsAdjuster(getInsertArgumentAdjuster(
-        UseCMode ? "-xc" : "-xc++", ArgumentInsertPosition::BEGIN));
+    return result;
+}
 
-    // Run the instantiated tool on the Chimera frontend.
-    return Tool.run(chimera::newFrontendActionFactory(Config).get());
+int run(int argc, const char **argv)
+{
+    // Invalid options and configurations are reported like the other errors
+    // instead of terminating the process.
+    try
+    {
+        return generate(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 }
 
 } // namespace chimera
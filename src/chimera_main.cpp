@@ -5,5 +5,5 @@
 
 int main(int argc, const char **argv)
 {
-    chimera::run(argc, argv);
+    return chimera::run(argc, argv);
 }
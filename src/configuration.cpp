@@ -2,14 +2,24 @@
 #include "chimera/mstch.h"
 #include "chimera/util.h"
 
+#include <algorithm>
 #include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
+#include <vector>
 
 #include <boost/optional.hpp>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Lex/HeaderSearch.h>
+#include <clang/Lex/Preprocessor.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
 
 using namespace clang;
 
@@ -17,42 +27,219 @@ namespace
 {
 
 /**
- * Map of counts of each long prefix encountered.
- *
- * This allows the generation of safe incrementing filenames in the case
- * that many long paths with the same prefix are encountered.
+ * Converts a scalar entry of a declaration configuration, if it exists.
  */
-std::map<std::string, int> large_filename_prefixes;
+template <typename T>
+boost::optional<T> parseScalar(const YAML::Node &node, const std::string &key)
+{
+    if (const YAML::Node value = node[key])
+        return value.as<T>();
+    return boost::none;
+}
+
+/**
+ * Fills in the typed fields of a declaration configuration from its YAML.
+ */
+void parseDeclarationConfig(const clang::Decl *decl,
+                            chimera::DeclarationConfig &config)
+{
+    // Suppressed (null) and scalar entries have no keys to convert.
+    const YAML::Node &node = config.node;
+    if (!node.IsMap())
+        return;
+
+    try
+    {
+        // Convert a `null` name to an empty string.  This helps users
+        // semantically mark names that should be omitted in their
+        // configuration files.
+        if (const YAML::Node name = node["name"])
+            config.name = name.IsNull() ? std::string{""}
+                                        : name.as<std::string>();
+
+        config.mangled_name = parseScalar<std::string>(node, "mangled_name");
+        config.qualified_name
+            = parseScalar<std::string>(node, "qualified_name");
+        config.type = parseScalar<std::string>(node, "type");
+        config.return_type = parseScalar<std::string>(node, "return_type");
+        config.return_value_policy
+            = parseScalar<std::string>(node, "return_value_policy");
+        config.call = parseScalar<std::string>(node, "call");
+        config.qualified_call
+            = parseScalar<std::string>(node, "qualified_call");
+        config.held_type = parseScalar<std::string>(node, "held_type");
+        config.is_copyable = parseScalar<bool>(node, "is_copyable");
+        config.is_assignable = parseScalar<bool>(node, "is_assignable");
+        if (const YAML::Node bases = node["bases"])
+            config.bases = bases;
+    }
+    catch (const YAML::Exception &e)
+    {
+        std::stringstream ss;
+        ss << "Invalid configuration for '";
+        if (const auto *named_decl = dyn_cast<NamedDecl>(decl))
+            ss << named_decl->getQualifiedNameAsString();
+        else
+            ss << decl->getDeclKindName();
+        ss << "': " << e.what();
+        throw std::runtime_error(ss.str());
+    }
+}
+
+/**
+ * Estimates the relative cost of compiling the binding of a declaration as
+ * the number of definitions that it registers, counting each overload that
+ * is generated for default arguments separately.
+ */
+std::size_t estimateBindingCost(const clang::Decl *decl)
+{
+    const auto getOverloadCount = [](const FunctionDecl *function_decl) {
+        const auto range
+            = chimera::util::getFunctionArgumentRange(function_decl);
+        return static_cast<std::size_t>(1 + range.second - range.first);
+    };
+
+    if (const auto *record_decl = dyn_cast<CXXRecordDecl>(decl))
+    {
+        std::size_t cost = 1;
+        for (const CXXMethodDecl *method_decl : record_decl->methods())
+            if (method_decl->getAccess() == AS_public)
+                cost += getOverloadCount(method_decl);
+        for (const FieldDecl *field_decl : record_decl->fields())
+            if (field_decl->getAccess() == AS_public)
+                ++cost;
+        return cost;
+    }
+
+    if (const auto *function_decl = dyn_cast<FunctionDecl>(decl))
+        return getOverloadCount(function_decl);
 
-constexpr int MAX_PATH_LENGTH = 255;
-constexpr int MAX_COUNTER_LENGTH = 4;
+    if (const auto *enum_decl = dyn_cast<EnumDecl>(decl))
+        return 1 + std::distance(enum_decl->enumerator_begin(),
+                                 enum_decl->enumerator_end());
+
+    return 1;
+}
+
+/**
+ * Appends the declaration of the class or enum referred to by a type, and of
+ * the classes and enums in its template arguments.  Pointers, references and
+ * arrays are looked through.
+ */
+void collectTypeDecls(QualType type, std::vector<const clang::Decl *> &decls)
+{
+    while (true)
+    {
+        type = type.getNonReferenceType();
+        if (const auto *pointer_type = type->getAs<PointerType>())
+            type = pointer_type->getPointeeType();
+        else if (const auto *array_type = type->getAsArrayTypeUnsafe())
+            type = array_type->getElementType();
+        else
+            break;
+    }
+
+    const TagDecl *tag_decl = type->getAsTagDecl();
+    if (!tag_decl)
+        return;
+
+    const TagDecl *definition = tag_decl->getDefinition();
+    decls.push_back(definition ? definition : tag_decl);
+
+    if (const auto *specialization_decl
+        = dyn_cast<ClassTemplateSpecializationDecl>(tag_decl))
+    {
+        for (const TemplateArgument &argument :
+             specialization_decl->getTemplateArgs().asArray())
+        {
+            if (argument.getKind() == TemplateArgument::Type)
+                collectTypeDecls(argument.getAsType(), decls);
+        }
+    }
+}
+
+/**
+ * Appends the declarations that an expression refers to, such as the
+ * constants and functions of a default argument, and those of the types of
+ * its subexpressions.
+ */
+void collectExprDecls(const Stmt *stmt, std::vector<const clang::Decl *> &decls)
+{
+    if (const auto *expr = dyn_cast<Expr>(stmt))
+        collectTypeDecls(expr->getType(), decls);
+    if (const auto *decl_ref_expr = dyn_cast<DeclRefExpr>(stmt))
+        decls.push_back(decl_ref_expr->getDecl());
+
+    for (const Stmt *child : stmt->children())
+        if (child)
+            collectExprDecls(child, decls);
+}
 
 /**
- * De-conflicts paths that are longer than 255 characters.
- * (This is the maximum path length on many operating systems.)
+ * Appends the declarations of the types that the binding of a declaration
+ * uses, including those that its default arguments refer to.
  */
-std::string sanitizePath(const std::string &path)
-{
-    // If the path length is short, just return it.
-    if (path.size() < MAX_PATH_LENGTH)
-        return path;
-
-    // If the path length is long, compute a safe prefix and append an
-    // incrementing counter variable to the end of the filename.
-    size_t suffix_index = path.find_last_of(".");
-    const std::string path_suffix
-        = (suffix_index == std::string::npos) ? "" : path.substr(suffix_index);
-    const int prefix_size = std::max(
-        0, MAX_PATH_LENGTH - MAX_COUNTER_LENGTH - (int)path_suffix.size() - 2);
-    const std::string path_prefix = path.substr(0, prefix_size);
-    const int index = large_filename_prefixes[path_prefix]++;
-
-    // Create the new filename as "prefix_{index}.suffix"
+void collectIncludeDecls(const clang::Decl *decl,
+                         std::vector<const clang::Decl *> &decls)
+{
+    const auto collectFunctionDecls = [&decls](const FunctionDecl *function) {
+        collectTypeDecls(function->getReturnType(), decls);
+        for (const ParmVarDecl *param_decl : function->parameters())
+        {
+            collectTypeDecls(param_decl->getType(), decls);
+            if (param_decl->hasDefaultArg()
+                && !param_decl->hasUnparsedDefaultArg()
+                && !param_decl->hasUninstantiatedDefaultArg())
+                collectExprDecls(param_decl->getDefaultArg(), decls);
+        }
+    };
+
+    if (const auto *record_decl = dyn_cast<CXXRecordDecl>(decl))
+    {
+        if (!record_decl->hasDefinition())
+            return;
+
+        for (const CXXBaseSpecifier &base : record_decl->bases())
+            if (base.getAccessSpecifier() == AS_public)
+                collectTypeDecls(base.getType(), decls);
+
+        for (const Decl *member_decl : record_decl->decls())
+        {
+            if (member_decl->getAccess() != AS_public)
+                continue;
+            if (const auto *method_decl = dyn_cast<CXXMethodDecl>(member_decl))
+                collectFunctionDecls(method_decl);
+            else if (const auto *field_decl = dyn_cast<FieldDecl>(member_decl))
+                collectTypeDecls(field_decl->getType(), decls);
+            else if (const auto *var_decl = dyn_cast<VarDecl>(member_decl))
+                collectTypeDecls(var_decl->getType(), decls);
+        }
+    }
+    else if (const auto *function_decl = dyn_cast<FunctionDecl>(decl))
+    {
+        collectFunctionDecls(function_decl);
+    }
+    else if (const auto *var_decl = dyn_cast<VarDecl>(decl))
+    {
+        collectTypeDecls(var_decl->getType(), decls);
+    }
+    else if (const auto *typedef_decl = dyn_cast<TypedefNameDecl>(decl))
+    {
+        collectTypeDecls(typedef_decl->getUnderlyingType(), decls);
+    }
+}
+
+/**
+ * Returns the path of the listing of a shard, which is named after the module
+ * like the manifest.
+ */
+std::string getShardListingPath(const std::string &output_path,
+                                const std::string &module_name,
+                                unsigned index, unsigned count)
+{
     std::stringstream ss;
-    ss << path_prefix << "_";
-    ss << std::setfill('0') << std::setw(MAX_COUNTER_LENGTH) << index;
-    if (path_suffix.length())
-        ss << path_suffix;
+    ss << output_path << "/" << module_name << ".shard-" << index << "-of-"
+       << count;
     return ss.str();
 }
 
@@ -61,8 +248,23 @@ std::string sanitizePath(const std::string &path)
 const YAML::Node chimera::CompiledConfiguration::emptyNode_(
     YAML::NodeType::Undefined);
 
+const chimera::DeclarationConfig
+    chimera::CompiledConfiguration::emptyDeclarationConfig_{};
+
 chimera::Configuration::Configuration()
-  : outputPath_("."), outputModuleName_("chimera_binding"), strict_(false)
+  : outputPath_(".")
+  , outputModuleName_("chimera_binding")
+  , strict_(false)
+  , releaseAST_(false)
+  , unityFileCount_(0)
+  , classSplitThreshold_(0)
+  , minimalIncludes_(false)
+  , prefixHeader_(false)
+  , listOutputs_(false)
+  , outputLayout_(OutputLayout::Flat)
+  , renderThreadCount_(1)
+  , shardIndex_(0)
+  , shardCount_(1)
 {
     // Do nothing.
 }
@@ -73,6 +275,7 @@ void chimera::Configuration::LoadFile(const std::string &filename)
     {
         configNode_ = YAML::LoadFile(filename);
         configFilename_ = filename;
+        AddInputFile(filename);
     }
     catch (YAML::Exception &e)
     {
@@ -84,6 +287,15 @@ void chimera::Configuration::LoadFile(const std::string &filename)
     }
 }
 
+void chimera::Configuration::SetRoot(const YAML::Node &root,
+                                     const std::string &filename)
+{
+    configNode_ = root;
+    configFilename_ = filename;
+    if (!filename.empty())
+        AddInputFile(filename);
+}
+
 void chimera::Configuration::SetBindingName(const std::string &name)
 {
     // Setting the name to the empty string makes no sense and will fail the
@@ -139,6 +351,302 @@ void chimera::Configuration::SetStrict(bool val)
     strict_ = val;
 }
 
+void chimera::Configuration::SetDependencyGraphPath(const std::string &path)
+{
+    dependencyGraphPath_ = path;
+}
+
+void chimera::Configuration::SetReleaseAST(bool val)
+{
+    releaseAST_ = val;
+}
+
+bool chimera::Configuration::GetReleaseAST() const
+{
+    return releaseAST_;
+}
+
+void chimera::Configuration::SetWriteQueueSize(unsigned size)
+{
+    outputWriter_.SetQueueSize(size);
+}
+
+void chimera::Configuration::SetUnityFileCount(unsigned count)
+{
+    unityFileCount_ = count;
+}
+
+void chimera::Configuration::SetClassSplitThreshold(unsigned threshold)
+{
+    classSplitThreshold_ = threshold;
+}
+
+void chimera::Configuration::SetMinimalIncludes(bool val)
+{
+    minimalIncludes_ = val;
+}
+
+void chimera::Configuration::SetPrefixHeader(bool val)
+{
+    prefixHeader_ = val;
+}
+
+void chimera::Configuration::SetListOutputs(bool val)
+{
+    listOutputs_ = val;
+}
+
+void chimera::Configuration::SetRenderThreadCount(unsigned count)
+{
+    renderThreadCount_ = count;
+}
+
+void chimera::Configuration::SetShard(unsigned index, unsigned count)
+{
+    if (count == 0 || index >= count)
+    {
+        std::stringstream ss;
+        ss << "Shard " << index << " is not one of " << count << " shards.";
+        throw std::invalid_argument(ss.str());
+    }
+    shardIndex_ = index;
+    shardCount_ = count;
+}
+
+bool chimera::Configuration::IsSharded() const
+{
+    return shardCount_ > 1;
+}
+
+void chimera::Configuration::SetDepfile(const std::string &path,
+                                        const std::string &target)
+{
+    depfilePath_ = path;
+    depfileTarget_ = target;
+}
+
+void chimera::Configuration::AddInputFile(const std::string &path) const
+{
+    // Record absolute paths, since depfiles are read relative to the build
+    // directory rather than to the working directory of chimera.
+    llvm::SmallString<256> absolute_path(path);
+    llvm::sys::fs::make_absolute(absolute_path);
+    llvm::sys::path::remove_dots(absolute_path, true);
+    inputFiles_.insert(absolute_path.str());
+}
+
+const std::set<std::string> &chimera::Configuration::GetInputFiles() const
+{
+    return inputFiles_;
+}
+
+void chimera::Configuration::WriteDepfile() const
+{
+    // A dry run leaves the depfile of the last full run in place.
+    if (depfilePath_.empty() || listOutputs_)
+        return;
+
+    // Spaces are escaped with a backslash and dollar signs are doubled, which
+    // both Make and Ninja understand.
+    const auto escape = [](const std::string &path) {
+        std::string escaped;
+        for (const char c : path)
+        {
+            if (c == ' ' || c == '#')
+                escaped += '\\';
+            else if (c == '$')
+                escaped += '$';
+            escaped += c;
+        }
+        return escaped;
+    };
+
+    std::ofstream depfile(depfilePath_);
+    if (depfile.fail())
+    {
+        std::stringstream ss;
+        ss << "Failed to create depfile '" << depfilePath_
+           << "': " << strerror(errno);
+        throw std::runtime_error(ss.str());
+    }
+
+    const std::string target
+        = depfileTarget_.empty()
+              ? outputPath_ + "/" + outputModuleName_ + ".cpp"
+              : depfileTarget_;
+    depfile << escape(target) << ":";
+    for (const std::string &input_file : inputFiles_)
+        depfile << " \\\n  " << escape(input_file);
+    depfile << "\n";
+}
+
+void chimera::Configuration::AddListedOutput(std::size_t position,
+                                             const std::string &path) const
+{
+    listedOutputs_.emplace_back(position, path);
+}
+
+void chimera::Configuration::WriteOutput(const std::string &path,
+                                         const std::string &content,
+                                         const std::string &name) const
+{
+    // Pass the rendered template to the output writer, which either writes
+    // it immediately or queues it for its background thread.
+    const bool written = outputWriter_.Write(path, content);
+
+    // If file creation failed, report the error and fail immediately.
+    if (!written)
+    {
+        std::stringstream ss;
+
+        if (!name.empty())
+        {
+            ss << "Failed to create output file '" << path << "' for '"
+               << name << "'.";
+        }
+        else
+        {
+            ss << "Failed to create top-level output file '" << path << "'";
+        }
+        throw std::runtime_error(ss.str());
+    }
+}
+
+void chimera::Configuration::AddDeferredOutput(const std::string &path,
+                                               const std::string &view,
+                                               ::mstch::node context,
+                                               const std::string &name) const
+{
+    const std::string *shared_view = &*deferredViews_.insert(view).first;
+    deferredOutputs_.push_back(
+        DeferredOutput{path, shared_view, std::move(context), name});
+}
+
+void chimera::Configuration::RenderDeferredOutputs() const
+{
+    std::vector<DeferredOutput> outputs;
+    outputs.swap(deferredOutputs_);
+
+    // The bindings are rendered in the order of the traversal, and the data
+    // of each is released once it has been rendered.
+    chimera::ThreadPool pool(renderThreadCount_);
+    for (DeferredOutput &output : outputs)
+    {
+        pool.Add(0, [this, &output]() {
+            const ::mstch::node context = std::move(output.context);
+            WriteOutput(output.path, ::mstch::render(*output.view, context),
+                        output.name);
+        });
+    }
+    pool.Wait();
+    deferredViews_.clear();
+}
+
+void chimera::Configuration::WriteShardListing() const
+{
+    // Listed outputs are prefixed by "out " and their position, and written
+    // files by "file ", with the latter relative to the output directory.
+    std::stringstream listing;
+    for (const auto &output : listedOutputs_)
+        listing << "out " << output.first << " " << output.second << "\n";
+    const std::string prefix = outputPath_ + "/";
+    for (const std::string &path : outputWriter_.GetPaths())
+    {
+        if (path.compare(0, prefix.size(), prefix) == 0)
+            listing << "file " << path.substr(prefix.size()) << "\n";
+        else
+            listing << "file " << path << "\n";
+    }
+
+    const std::string listing_path = getShardListingPath(
+        outputPath_, outputModuleName_, shardIndex_, shardCount_);
+    std::ofstream listing_file(listing_path);
+    if (listing_file.fail())
+    {
+        std::stringstream ss;
+        ss << "Failed to create shard listing '" << listing_path
+           << "': " << strerror(errno);
+        throw std::runtime_error(ss.str());
+    }
+    listing_file << listing.str();
+}
+
+void chimera::Configuration::MergeShards(unsigned count) const
+{
+    std::vector<std::pair<std::size_t, std::string>> outputs;
+    for (unsigned index = 0; index < count; ++index)
+    {
+        const std::string listing_path
+            = getShardListingPath(outputPath_, outputModuleName_, index, count);
+        std::ifstream listing_file(listing_path);
+        if (listing_file.fail())
+        {
+            std::stringstream ss;
+            ss << "Failed to open shard listing '" << listing_path
+               << "': " << strerror(errno);
+            throw std::runtime_error(ss.str());
+        }
+
+        // Record the inputs of the merge, so that it reruns whenever one of
+        // the shards changes.
+        AddInputFile(listing_path);
+
+        std::string line;
+        while (std::getline(listing_file, line))
+        {
+            if (line.compare(0, 4, "out ") == 0)
+            {
+                const std::size_t separator = line.find(' ', 4);
+                if (separator == std::string::npos)
+                    continue;
+                outputs.emplace_back(
+                    std::stoul(line.substr(4, separator - 4)),
+                    line.substr(separator + 1));
+            }
+            else if (line.compare(0, 5, "file ") == 0)
+            {
+                const std::string path = line.substr(5);
+                outputWriter_.Keep(llvm::sys::path::is_absolute(path)
+                                       ? path
+                                       : outputPath_ + "/" + path);
+            }
+        }
+    }
+
+    // List the outputs in the order of an unsharded run, so that the combined
+    // list does not change with the number of shards.
+    std::stable_sort(outputs.begin(), outputs.end(),
+                     [](const std::pair<std::size_t, std::string> &lhs,
+                        const std::pair<std::size_t, std::string> &rhs) {
+                         return lhs.first < rhs.first;
+                     });
+    for (const auto &output : outputs)
+    {
+        std::cout << output.second << std::endl;
+        AddListedOutput(output.first, output.second);
+    }
+}
+
+void chimera::Configuration::RemoveStaleOutputs() const
+{
+    // The manifest is named after the module, like its other top-level
+    // files.
+    const std::string manifest_path
+        = outputPath_ + "/" + outputModuleName_ + ".manifest";
+    const std::vector<std::string> removed_paths
+        = outputWriter_.UpdateManifest(manifest_path);
+
+    for (const std::string &path : removed_paths)
+        std::cerr << "Removed stale output file '" << path << "'."
+                  << std::endl;
+    statistics_.Set("stale files removed", removed_paths.size());
+}
+
+void chimera::Configuration::SetOutputLayout(OutputLayout layout)
+{
+    outputLayout_ = layout;
+}
+
 std::unique_ptr<chimera::CompiledConfiguration> chimera::Configuration::Process(
     CompilerInstance *ci) const
 {
@@ -166,12 +674,24 @@ const std::string &chimera::Configuration::GetOutputModuleName() const
     return outputModuleName_;
 }
 
+chimera::Statistics &chimera::Configuration::GetStatistics() const
+{
+    return statistics_;
+}
+
+chimera::OutputWriter &chimera::Configuration::GetOutputWriter() const
+{
+    return outputWriter_;
+}
+
 chimera::CompiledConfiguration::CompiledConfiguration(
     const chimera::Configuration &parent, CompilerInstance *ci)
   : parent_(parent)
   , configNode_(parent.GetRoot())         // TODO: do we need this reference?
   , bindingNode_(configNode_["template"]) // TODO: is this always ok?
   , ci_(ci)
+  , listed_output_count_(0)
+  , render_pool_(parent.renderThreadCount_)
 {
     using chimera::util::lookupYAMLNode;
 
@@ -255,7 +775,7 @@ chimera::CompiledConfiguration::CompiledConfiguration(
                     }
                     else
                     {
-                        declarations_[ns] = it.second;
+                        declarations_[ns].node = it.second;
                         namespacesIncluded_.insert(ns);
                     }
                 }
@@ -302,7 +822,7 @@ chimera::CompiledConfiguration::CompiledConfiguration(
                         = chimera::util::resolveClassTemplate(ci, decl_str);
                     if (decl)
                     {
-                        declarations_[decl] = it.second;
+                        declarations_[decl].node = it.second;
                         continue;
                     }
                 }
@@ -311,7 +831,7 @@ chimera::CompiledConfiguration::CompiledConfiguration(
                     auto decl = chimera::util::resolveRecord(ci, decl_str);
                     if (decl)
                     {
-                        declarations_[decl] = it.second;
+                        declarations_[decl].node = it.second;
                         continue;
                     }
                 }
@@ -351,7 +871,7 @@ chimera::CompiledConfiguration::CompiledConfiguration(
                 auto decl = chimera::util::resolveDeclaration(ci, decl_str);
                 if (decl)
                 {
-                    declarations_[decl] = it.second;
+                    declarations_[decl].node = it.second;
                 }
                 else
                 {
@@ -373,6 +893,27 @@ chimera::CompiledConfiguration::CompiledConfiguration(
             }
         }
 
+        // Convert the keys of each declaration configuration that chimera
+        // interprets into typed fields.
+        for (auto &entry : declarations_)
+            parseDeclarationConfig(entry.first, entry.second);
+
+        // Resolve the held types of classes that are included minimally, so
+        // that the bindings do not parse them while they are rendered.
+        if (parent_.minimalIncludes_)
+        {
+            for (const auto &entry : declarations_)
+            {
+                if (!entry.second.held_type)
+                    continue;
+
+                const QualType held_type = chimera::util::resolveType(
+                    ci, *entry.second.held_type);
+                if (held_type.getTypePtrOrNull())
+                    heldTypes_.emplace(entry.first, held_type);
+            }
+        }
+
         // Parse 'types' section of configuration YAML if it exists.
         const YAML::Node typesNode = configNode_["types"];
         if (typesNode)
@@ -411,9 +952,11 @@ chimera::CompiledConfiguration::CompiledConfiguration(
             }
         }
 
-        // Parse 'binding' section of configuration YAML if it exists.
+        // Parse 'binding' section of configuration YAML if it exists.  If it
+        // lists several bindings, the generator creates a configuration for
+        // each of them with the binding name set.
         const YAML::Node bindingNode = configNode_["binding"];
-        if (bindingNode)
+        if (bindingNode && parent_.bindingName_.empty())
         {
             // Check that 'binding' node in configuration YAML is a scalar.
             if (!bindingNode.IsScalar())
@@ -453,6 +996,14 @@ chimera::CompiledConfiguration::CompiledConfiguration(
     // Override individual templates if specified in the configuration.
     SetBindingDefinitions("class", bindingDefinition_.class_h,
                           bindingDefinition_.class_cpp);
+    SetClassPartDefinition(bindingDefinition_.class_part_cpp);
+    if (const auto prefix_node
+        = chimera::util::lookupYAMLNode(bindingNode_, "prefix"))
+    {
+        bindingDefinition_.prefix_h = prefix_node.IsNull()
+                                          ? chimera::util::FLAG_NO_RENDER
+                                          : Lookup(prefix_node);
+    }
     SetBindingDefinitions("enum", bindingDefinition_.enum_h,
                           bindingDefinition_.enum_cpp);
     SetBindingDefinitions("function", bindingDefinition_.function_h,
@@ -471,8 +1022,13 @@ chimera::CompiledConfiguration::CompiledConfiguration(
     //
     // See: https://github.com/no1msd/mstch#custom-escape-function
     //
-    ::mstch::config::escape
-        = [](const std::string &str) -> std::string { return str; };
+    // The escape function is global, so it is only set once in case several
+    // configurations are compiled at the same time.
+    static std::once_flag escape_flag;
+    std::call_once(escape_flag, []() {
+        ::mstch::config::escape
+            = [](const std::string &str) -> std::string { return str; };
+    });
 }
 
 bool chimera::CompiledConfiguration::GetStrict() const
@@ -501,7 +1057,7 @@ void chimera::CompiledConfiguration::AddTraversedNamespace(
     if (result.second)
     {
         binding_namespaces_.push_back(
-            std::make_shared<chimera::mstch::Namespace>(*this, decl));
+            MakeWrapper<chimera::mstch::Namespace>(decl));
     }
 }
 
@@ -519,9 +1075,16 @@ const std::set<const clang::NamespaceDecl *>
 
 const YAML::Node &chimera::CompiledConfiguration::GetDeclaration(
     const clang::Decl *decl) const
+{
+    return GetDeclarationConfig(decl).node;
+}
+
+const chimera::DeclarationConfig &
+chimera::CompiledConfiguration::GetDeclarationConfig(
+    const clang::Decl *decl) const
 {
     const auto d = declarations_.find(decl->getCanonicalDecl());
-    return d != declarations_.end() ? d->second : emptyNode_;
+    return d != declarations_.end() ? d->second : emptyDeclarationConfig_;
 }
 
 const YAML::Node &chimera::CompiledConfiguration::GetType(
@@ -547,6 +1110,22 @@ clang::ASTContext &chimera::CompiledConfiguration::GetContext() const
     return ci_->getASTContext();
 }
 
+std::size_t chimera::CompiledConfiguration::GetWrapperBytesAllocated() const
+{
+    return arena_.GetBytesAllocated();
+}
+
+chimera::DependencyGraph &chimera::CompiledConfiguration::GetDependencyGraph()
+{
+    return dependency_graph_;
+}
+
+const chimera::DependencyGraph &
+chimera::CompiledConfiguration::GetDependencyGraph() const
+{
+    return dependency_graph_;
+}
+
 const std::string &chimera::CompiledConfiguration::GetBindingName() const
 {
     return binding_name_;
@@ -583,10 +1162,10 @@ bool chimera::CompiledConfiguration::IsSuppressed(const clang::Decl *decl) const
     if (!IsEnclosed(decl))
         return true;
 
-    const auto config = GetDeclaration(decl);
+    const DeclarationConfig &config = GetDeclarationConfig(decl);
 
     // If the declaration is directly suppressed, report this.
-    if (config.IsNull())
+    if (config.node.IsNull())
         return true;
 
     // If the (canonical) declaration is specialized template class, check if
@@ -596,8 +1175,7 @@ bool chimera::CompiledConfiguration::IsSuppressed(const clang::Decl *decl) const
         = dyn_cast<ClassTemplateSpecializationDecl>(canonical_decl))
     {
         auto templ_decl = specialized_templ_decl->getSpecializedTemplate();
-        const auto config = GetDeclaration(templ_decl);
-        if (config.IsNull())
+        if (GetDeclaration(templ_decl).IsNull())
             return true;
     }
 
@@ -608,7 +1186,7 @@ bool chimera::CompiledConfiguration::IsSuppressed(const clang::Decl *decl) const
         const FunctionDecl *function_decl = cast<FunctionDecl>(decl);
 
         // Check if they return a suppressed type.
-        if (!config["return_value_policy"])
+        if (!config.return_value_policy)
         {
             const QualType return_qual_type
                 = chimera::util::getFullyQualifiedType(
@@ -649,7 +1227,7 @@ bool chimera::CompiledConfiguration::IsSuppressed(const clang::Decl *decl) const
         }
     }
     // Fields can be suppressed if they represent a suppressed type.
-    else if (isa<FieldDecl>(decl) && !config["return_value_policy"])
+    else if (isa<FieldDecl>(decl) && !config.return_value_policy)
     {
         const FieldDecl *field_decl = cast<FieldDecl>(decl);
         const QualType value_qual_type = chimera::util::getFullyQualifiedType(
@@ -693,6 +1271,9 @@ std::string chimera::CompiledConfiguration::Lookup(const YAML::Node &node) const
             }
         }
 
+        // Regenerate the bindings whenever the snippet changes.
+        parent_.AddInputFile(source_path);
+
         // Try to open configuration file.
         std::ifstream source(source_path);
         if (source.fail())
@@ -715,8 +1296,8 @@ std::string chimera::CompiledConfiguration::Lookup(const YAML::Node &node) const
 }
 
 bool chimera::CompiledConfiguration::Render(
-    const std::string &key, const std::string &header_view,
-    const std::string &source_view,
+    const std::string &key, const clang::Decl *decl,
+    const std::string &header_view, const std::string &source_view,
     const std::shared_ptr<::mstch::object> &context)
 {
     // Get the mangled name property if it exists.
@@ -728,10 +1309,64 @@ bool chimera::CompiledConfiguration::Render(
     }
     const std::string mangled_name
         = ::mstch::render("{{mangled_name}}", context);
+    const std::string output_name = GetOutputName(decl, mangled_name);
+
+    const ::mstch::map full_context = CreateFileContext(key, decl, context);
+
+    // Count the bindings that include each source, to find the sources that
+    // are common enough to be part of the prefix header.
+    for (const ::mstch::node &source :
+         boost::get<::mstch::array>(full_context.at("sources")))
+    {
+        const std::string &source_path = boost::get<std::string>(source);
+        const auto inserted = source_count_indices_.emplace(
+            source_path, source_counts_.size());
+        if (inserted.second)
+            source_counts_.emplace_back(source_path, 0);
+        ++source_counts_[inserted.first->second].second;
+    }
+
+    if (!Render(output_name, header_view, "h", context, full_context))
+        return false;
+
+    if (!RenderSource(output_name, source_view, context, full_context,
+                      estimateBindingCost(decl)))
+        return false;
+
+    // Record this binding for use at the top-level.
+    dependency_graph_.AddBinding(decl, mangled_name);
+    return true;
+}
+
+bool chimera::CompiledConfiguration::RenderSource(
+    const std::string &mangled_name, const std::string &view,
+    const std::shared_ptr<::mstch::object> &context,
+    const ::mstch::map &full_context, std::size_t cost)
+{
+    // In unity mode, binding sources are compiled as part of the unity
+    // sources, so they are not listed as outputs themselves.
+    const bool unity = parent_.unityFileCount_ > 0;
+    if (!Render(mangled_name, view, "cpp", context, full_context, !unity))
+        return false;
+
+    if (unity && view != chimera::util::FLAG_NO_RENDER)
+    {
+        unity_sources_.emplace_back(
+            GetRelativePath(GetBindingPath(mangled_name, "cpp")), cost);
+    }
+    return true;
+}
 
+::mstch::map chimera::CompiledConfiguration::CreateFileContext(
+    const std::string &key, const clang::Decl *decl,
+    const std::shared_ptr<::mstch::object> &context) const
+{
     // Create collections for the ordered sets of sources.
-    ::mstch::array binding_sources(parent_.inputSourcePaths_.begin(),
-                                   parent_.inputSourcePaths_.end());
+    ::mstch::array binding_sources
+        = parent_.minimalIncludes_
+              ? GetMinimalSources(decl)
+              : ::mstch::array(parent_.inputSourcePaths_.begin(),
+                               parent_.inputSourcePaths_.end());
 
     // Create a top-level context that contains the extracted information
     // about this particular binding component.
@@ -746,23 +1381,114 @@ bool chimera::CompiledConfiguration::Render(
             std::bind(&chimera::CompiledConfiguration::Lookup, this,
                       std::placeholders::_1));
     }
+    return full_context;
+}
 
-    if (!Render(mangled_name, header_view, "h", context, full_context))
-        return false;
+::mstch::array chimera::CompiledConfiguration::GetMinimalSources(
+    const clang::Decl *decl) const
+{
+    // Start with the declaration itself, followed by the declarations of the
+    // types that its binding uses and of the type that holds its instances.
+    std::vector<const clang::Decl *> include_decls{decl};
+    collectIncludeDecls(decl, include_decls);
+    const auto held_type = heldTypes_.find(decl->getCanonicalDecl());
+    if (held_type != heldTypes_.end())
+        collectTypeDecls(held_type->second, include_decls);
+
+    std::vector<FileID> include_files;
+    for (const clang::Decl *include_decl : include_decls)
+    {
+        const FileID file_id = GetIncludeFile(include_decl->getLocation());
+        if (file_id.isValid())
+            include_files.push_back(file_id);
+    }
 
-    if (!Render(mangled_name, source_view, "cpp", context, full_context))
-        return false;
+    // Include the headers in the order in which the sources include them,
+    // since headers may rely on what the headers before them include.
+    const SourceManager &source_manager = ci_->getSourceManager();
+    const auto getIncludeLoc = [&source_manager](FileID file_id) {
+        return file_id == source_manager.getMainFileID()
+                   ? source_manager.getLocForStartOfFile(file_id)
+                   : source_manager.getIncludeLoc(file_id);
+    };
+    std::sort(include_files.begin(), include_files.end(),
+              [&](FileID lhs, FileID rhs) {
+                  return source_manager.isBeforeInTranslationUnit(
+                      getIncludeLoc(lhs), getIncludeLoc(rhs));
+              });
+    include_files.erase(std::unique(include_files.begin(), include_files.end()),
+                        include_files.end());
+
+    ::mstch::array binding_sources;
+    std::set<std::string> include_paths;
+    for (const FileID file_id : include_files)
+    {
+        const std::string include_path = GetIncludePath(file_id);
+        if (!include_path.empty() && include_paths.insert(include_path).second)
+            binding_sources.push_back(include_path);
+    }
+    return binding_sources;
+}
 
-    // Record this binding name for use at the top-level.
-    binding_names_.push_back(mangled_name);
-    return true;
+clang::FileID chimera::CompiledConfiguration::GetIncludeFile(
+    clang::SourceLocation loc) const
+{
+    const SourceManager &source_manager = ci_->getSourceManager();
+    if (loc.isInvalid())
+        return FileID();
+
+    // Walk up the include stack to the file that is included by the main
+    // file, so that private headers are reached through their public header.
+    const FileID main_file_id = source_manager.getMainFileID();
+    FileID file_id
+        = source_manager.getFileID(source_manager.getExpansionLoc(loc));
+    while (file_id != main_file_id)
+    {
+        const SourceLocation include_loc
+            = source_manager.getIncludeLoc(file_id);
+        if (include_loc.isInvalid())
+            return FileID(); // built-in declarations have no header
+
+        // Files included from the command line are also top-level headers.
+        const FileID parent_file_id = source_manager.getFileID(include_loc);
+        if (parent_file_id == main_file_id
+            || !source_manager.getFileEntryForID(parent_file_id))
+            break;
+        file_id = parent_file_id;
+    }
+    return file_id;
+}
+
+std::string chimera::CompiledConfiguration::GetIncludePath(
+    clang::FileID file_id) const
+{
+    const SourceManager &source_manager = ci_->getSourceManager();
+    const FileID main_file_id = source_manager.getMainFileID();
+
+    const FileEntry *file = source_manager.getFileEntryForID(file_id);
+    if (!file)
+        return "";
+
+    // Declarations in the main file are included through the matching
+    // source path, as it was given to chimera.
+    if (file_id == main_file_id)
+    {
+        for (const std::string &source_path : parent_.inputSourcePaths_)
+            if (llvm::sys::fs::equivalent(source_path, file->getName()))
+                return source_path;
+        return file->getName();
+    }
+
+    return ci_->getPreprocessor()
+        .getHeaderSearchInfo()
+        .suggestPathToFileForDiagnostics(file);
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::string &mangled_name, const std::string &view,
     const std::string &extension,
     const std::shared_ptr<::mstch::object> &context,
-    const ::mstch::map &full_context)
+    const ::mstch::map &full_context, bool listed)
 {
     if (view == chimera::util::FLAG_NO_RENDER)
         return true;
@@ -770,97 +1496,299 @@ bool chimera::CompiledConfiguration::Render(
     // Create and sanitize path and filename of top-level source file.
     // Because we may compress the filename to fit OS character limits,
     // we generate the full path, then split the filename from it.
-    const std::string binding_path = sanitizePath(
-        parent_.GetOutputPath() + "/" + mangled_name + "." + extension);
-    size_t path_index = binding_path.find_last_of("/");
-    const std::string binding_filename
-        = (path_index == std::string::npos)
-              ? ""
-              : binding_path.substr(path_index + 1);
-
-    // Create an output file depending on the provided parameters.
-    auto stream = ci_->createOutputFile(
-        binding_path,
-        false, // Open the file in binary mode
-        false, // Register with llvm::sys::RemoveFileOnSignal
-        "",    // The derived basename (shouldn't be used)
-        "",    // The extension to use for derived name (shouldn't be used)
-        false, // Use a temporary file that should be renamed
-        false  // Create missing directories in the output path
-    );
+    const std::string binding_path = GetBindingPath(mangled_name, extension);
+    const std::string binding_filename = GetRelativePath(binding_path);
 
-    // If file creation failed, report the error and fail immediately.
-    if (!stream)
+    // Every shard counts every listed output, so that the merge can list
+    // them in the same order as an unsharded run.
+    const std::size_t position = listed ? listed_output_count_++ : 0;
+
+    // In a sharded run, the files of the other shards are left to them.
+    if (!IsRenderedByShard(mangled_name, !context))
+        return true;
+
+    // When only listing outputs, skip rendering and writing entirely.
+    if (parent_.listOutputs_)
     {
-        std::stringstream ss;
+        if (listed)
+        {
+            std::cout << binding_filename << std::endl;
+            parent_.AddListedOutput(position, binding_filename);
+        }
+        return true;
+    }
+
+    // Without the AST, and with several render threads, the template is
+    // expanded later from the parts of the context that it uses, which are
+    // evaluated here, since the wrappers query the AST, which is not safe to
+    // use concurrently.
+    const std::string name
+        = context ? ::mstch::render("{{name}}", context) : "";
+    if (parent_.releaseAST_)
+    {
+        parent_.AddDeferredOutput(binding_path, view,
+                                  ::mstch::extract(view, full_context), name);
+    }
+    else if (render_pool_.GetNumThreads() > 1)
+    {
+        const ::mstch::node plain_context
+            = ::mstch::extract(view, full_context);
+        pending_outputs_.push_back(
+            [this, binding_path, view, plain_context, name]() {
+                parent_.WriteOutput(binding_path,
+                                    ::mstch::render(view, plain_context), name);
+            });
+    }
+    else
+    {
+        parent_.WriteOutput(binding_path, ::mstch::render(view, full_context),
+                            name);
+    }
+
+    // The outputs of a shard are listed by the merge of all shards instead.
+    if (listed)
+    {
+        if (!parent_.IsSharded())
+            std::cout << binding_filename << std::endl;
+        parent_.AddListedOutput(position, binding_filename);
+    }
+
+    return true;
+}
+
+void chimera::CompiledConfiguration::SubmitPendingOutputs(std::size_t cost)
+{
+    if (pending_outputs_.empty())
+        return;
+
+    // The outputs of a declaration are rendered as one task, whose cost is
+    // estimated from the declaration.
+    std::vector<std::function<void()>> outputs;
+    outputs.swap(pending_outputs_);
+    render_pool_.Add(cost, [outputs]() {
+        for (const std::function<void()> &output : outputs)
+            output();
+    });
+}
+
+std::string chimera::CompiledConfiguration::GetHeaderPath(
+    const clang::Decl *decl, const std::string &mangled_name) const
+{
+    return GetRelativePath(
+        GetBindingPath(GetOutputName(decl, mangled_name), "h"));
+}
+
+std::string chimera::CompiledConfiguration::GetBindingPath(
+    const std::string &mangled_name, const std::string &extension) const
+{
+    return chimera::util::sanitizePath(parent_.GetOutputPath() + "/"
+                                       + mangled_name + "." + extension);
+}
 
-        if (context)
+std::string chimera::CompiledConfiguration::GetOutputName(
+    const clang::Decl *decl, const std::string &mangled_name) const
+{
+    switch (parent_.outputLayout_)
+    {
+        case OutputLayout::Flat:
+            break;
+        case OutputLayout::Hash:
         {
-            ss << "Failed to create output file '" << binding_path << "' for '"
-               << ::mstch::render("{{name}}", context) << "'.";
+            // Spread the bindings over 256 subdirectories by their name, so
+            // that a binding keeps its subdirectory from run to run.
+            std::stringstream ss;
+            ss << std::hex << std::setfill('0') << std::setw(2)
+               << (chimera::util::stableHash(mangled_name) & 0xff) << "/"
+               << mangled_name;
+            return ss.str();
         }
-        else
+        case OutputLayout::Namespace:
         {
-            ss << "Failed to create top-level output file '" << binding_path
-               << "'";
+            // Nest the binding in the named namespaces that enclose it.
+            std::string directory;
+            for (const DeclContext *context = decl->getDeclContext();
+                 context != nullptr; context = context->getParent())
+            {
+                const auto *namespace_decl = dyn_cast<NamespaceDecl>(context);
+                if (namespace_decl && !namespace_decl->isAnonymousNamespace())
+                    directory = namespace_decl->getNameAsString() + "/"
+                                + directory;
+            }
+            return directory + mangled_name;
         }
-        throw std::runtime_error(ss.str());
     }
+    return mangled_name;
+}
 
-    // Render the mstch template to the given output file.
-    *stream << ::mstch::render(view, full_context);
-    std::cout << binding_filename << std::endl;
+bool chimera::CompiledConfiguration::IsRenderedByShard(
+    const std::string &mangled_name, bool top_level) const
+{
+    if (!parent_.IsSharded())
+        return true;
+    if (top_level)
+        return parent_.shardIndex_ == 0;
+    return chimera::util::stableHash(mangled_name) % parent_.shardCount_
+           == parent_.shardIndex_;
+}
 
-    return true;
+std::string chimera::CompiledConfiguration::GetRelativePath(
+    const std::string &binding_path) const
+{
+    // Outputs are listed relative to the output directory, unless the path
+    // had to be shortened into a different directory.
+    const std::string prefix = parent_.GetOutputPath() + "/";
+    if (binding_path.compare(0, prefix.size(), prefix) == 0)
+        return binding_path.substr(prefix.size());
+    return binding_path.substr(binding_path.find_last_of("/") + 1);
+}
+
+void chimera::CompiledConfiguration::RenderUnitySources()
+{
+    if (parent_.unityFileCount_ == 0 || unity_sources_.empty())
+        return;
+
+    std::vector<std::size_t> costs;
+    for (const auto &unity_source : unity_sources_)
+        costs.push_back(unity_source.second);
+    const std::vector<std::vector<std::size_t>> unity_members
+        = chimera::util::partitionByCost(costs, parent_.unityFileCount_);
+    const std::size_t unity_count = unity_members.size();
+
+    // Include the binding sources of each unity source in rendering order.
+    for (std::size_t i = 0; i < unity_count; ++i)
+    {
+        const std::vector<std::size_t> &members = unity_members[i];
+        std::size_t unity_cost = 0;
+        for (const std::size_t index : members)
+            unity_cost += costs[index];
+
+        std::stringstream ss;
+        ss << "// Automatically generated by chimera.\n"
+           << "// Merges " << members.size() << " binding sources of "
+           << "estimated cost " << unity_cost << ".\n\n";
+        for (const std::size_t index : members)
+            ss << "#include \"" << unity_sources_[index].first << "\"\n";
+
+        const std::string mangled_name = parent_.GetOutputModuleName()
+                                         + "_unity_" + std::to_string(i);
+        Render(mangled_name, ss.str(), "cpp", nullptr, ::mstch::map{});
+    }
+
+    parent_.GetStatistics().Set("unity sources", unity_count);
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::CXXRecord> context)
 {
-    return Render("class", bindingDefinition_.class_h,
-                  bindingDefinition_.class_cpp, context);
+    const bool rendered = RenderClass(context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
+}
+
+bool chimera::CompiledConfiguration::RenderClass(
+    const std::shared_ptr<chimera::mstch::CXXRecord> context)
+{
+    const CXXRecordDecl *decl = context->getDecl();
+    const std::size_t threshold = parent_.classSplitThreshold_;
+    if (threshold == 0
+        || bindingDefinition_.class_part_cpp == chimera::util::FLAG_NO_RENDER)
+    {
+        return Render("class", decl, bindingDefinition_.class_h,
+                      bindingDefinition_.class_cpp, context);
+    }
+
+    // Register the first range of instance methods in the class source, and
+    // each of the remaining ranges in a part source of its own.
+    const auto ranges = context->splitMethods(threshold);
+    if (ranges.size() > 1)
+    {
+        context->setMethodRange(ranges.front().first, ranges.front().second,
+                                ranges.size() - 1);
+    }
+
+    if (!Render("class", decl, bindingDefinition_.class_h,
+                bindingDefinition_.class_cpp, context))
+        return false;
+
+    const std::string output_name
+        = GetOutputName(decl, ::mstch::render("{{mangled_name}}", context));
+    for (std::size_t index = 1; index < ranges.size(); ++index)
+    {
+        const auto part
+            = context->createPart(ranges[index].first, ranges[index].second);
+        ::mstch::map full_context = CreateFileContext("class", decl, part);
+        full_context["part"]
+            = ::mstch::map{{"index", static_cast<int>(index)}};
+
+        if (!RenderSource(output_name + "_part_" + std::to_string(index),
+                          bindingDefinition_.class_part_cpp, part, full_context,
+                          ranges[index].second - ranges[index].first))
+            return false;
+    }
+
+    if (ranges.size() > 1)
+        parent_.GetStatistics().Add("split classes");
+    return true;
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::Enum> context)
 {
-    return Render("enum", bindingDefinition_.enum_h,
-                  bindingDefinition_.enum_cpp, context);
+    const bool rendered
+        = Render("enum", context->getDecl(), bindingDefinition_.enum_h,
+                 bindingDefinition_.enum_cpp, context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::Function> context)
 {
-    return Render("function", bindingDefinition_.function_h,
-                  bindingDefinition_.function_cpp, context);
+    const bool rendered
+        = Render("function", context->getDecl(), bindingDefinition_.function_h,
+                 bindingDefinition_.function_cpp, context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::Variable> context)
 {
-    return Render("variable", bindingDefinition_.variable_h,
-                  bindingDefinition_.variable_cpp, context);
+    const bool rendered
+        = Render("variable", context->getDecl(), bindingDefinition_.variable_h,
+                 bindingDefinition_.variable_cpp, context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::Typedef> context)
 {
-    return Render("typedef", bindingDefinition_.typedef_h,
-                  bindingDefinition_.typedef_cpp, context);
+    const bool rendered
+        = Render("typedef", context->getDecl(), bindingDefinition_.typedef_h,
+                 bindingDefinition_.typedef_cpp, context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
 }
 
 bool chimera::CompiledConfiguration::Render(
     const std::shared_ptr<chimera::mstch::BuiltinTypedef> context)
 {
-    return Render("typedef", bindingDefinition_.typedef_h,
-                  bindingDefinition_.typedef_cpp, context);
+    const bool rendered
+        = Render("typedef", context->getDecl(), bindingDefinition_.typedef_h,
+                 bindingDefinition_.typedef_cpp, context);
+    SubmitPendingOutputs(estimateBindingCost(context->getDecl()));
+    return rendered;
 }
 
 void chimera::CompiledConfiguration::Render()
 {
     // Create collections for the ordered sets of bindings, sources,
     // and namespaces.
-    ::mstch::array binding_names(binding_names_.begin(), binding_names_.end());
+    const std::vector<std::string> ordered_binding_names
+        = dependency_graph_.GetTopologicalOrder();
+    ::mstch::array binding_names(ordered_binding_names.begin(),
+                                 ordered_binding_names.end());
     ::mstch::array binding_namespaces(binding_namespaces_.begin(),
                                       binding_namespaces_.end());
     ::mstch::array binding_sources(parent_.inputSourcePaths_.begin(),
@@ -891,6 +1819,86 @@ void chimera::CompiledConfiguration::Render()
     Render(filename, bindingDefinition_.module_h, "h", nullptr, full_context);
     Render(filename, bindingDefinition_.module_cpp, "cpp", nullptr,
            full_context);
+    RenderUnitySources();
+    RenderPrefixHeader();
+
+    // Hand the top-level outputs to the render threads, with them costing
+    // about as much as one binding each, and wait for all outputs.
+    SubmitPendingOutputs(dependency_graph_.GetNumBindings());
+    render_pool_.Wait();
+
+    // Export the dependency graph if it was requested.  It is the same for
+    // every shard, so only the first one exports it, and a dry run does not.
+    if (!parent_.dependencyGraphPath_.empty() && !parent_.listOutputs_
+        && IsRenderedByShard(filename, true))
+    {
+        std::ofstream graph_file(parent_.dependencyGraphPath_);
+        if (graph_file.fail())
+        {
+            std::stringstream ss;
+            ss << "Failed to create dependency graph file '"
+               << parent_.dependencyGraphPath_ << "': " << strerror(errno);
+            throw std::runtime_error(ss.str());
+        }
+        dependency_graph_.WriteDot(graph_file);
+    }
+}
+
+void chimera::CompiledConfiguration::SetClassPartDefinition(
+    std::string &part_def)
+{
+    using chimera::util::lookupYAMLNode;
+
+    const auto node = lookupYAMLNode(bindingNode_, "class");
+    if (!node)
+        return;
+
+    // The part source extends the class object declared by the class source,
+    // so a custom class source disables splitting unless it comes with a
+    // custom part source.
+    if (node.IsMap())
+    {
+        if (const auto part_node = lookupYAMLNode(node, "part"))
+        {
+            part_def = part_node.IsNull() ? chimera::util::FLAG_NO_RENDER
+                                          : Lookup(part_node);
+            return;
+        }
+        if (!lookupYAMLNode(node, "source"))
+            return;
+    }
+    part_def = chimera::util::FLAG_NO_RENDER;
+}
+
+void chimera::CompiledConfiguration::RenderPrefixHeader()
+{
+    if (!parent_.prefixHeader_)
+        return;
+
+    // Only include the sources that at least half of the bindings include,
+    // since every binding pays for parsing the precompiled header.
+    const std::size_t num_bindings = dependency_graph_.GetNumBindings();
+    ::mstch::array prefix_sources;
+    for (const auto &source_count : source_counts_)
+        if (2 * source_count.second >= num_bindings)
+            prefix_sources.push_back(source_count.first);
+
+    ::mstch::map full_context{
+        {"module", ::mstch::map{{"name", parent_.GetOutputModuleName()}}},
+        {"sources", prefix_sources}};
+
+    // Resolve the customizable snippets of the binding files, since the
+    // prefix header is included by each of them.
+    if (bindingNode_)
+    {
+        chimera::util::extendWithYAMLNode(
+            full_context, bindingNode_["file"], false,
+            std::bind(&chimera::CompiledConfiguration::Lookup, this,
+                      std::placeholders::_1));
+    }
+
+    Render(parent_.GetOutputModuleName() + "_prefix",
+           bindingDefinition_.prefix_h, "h", nullptr, full_context);
 }
 
 void chimera::CompiledConfiguration::SetBindingDefinitions(
@@ -1,28 +1,69 @@
 #include "chimera/consumer.h"
+#include "chimera/util.h"
 #include "chimera/visitor.h"
 
 #include <iostream>
+#include <clang/Basic/SourceManager.h>
 
 using namespace clang;
 
-chimera::Consumer::Consumer(CompilerInstance *ci,
-                            const chimera::Configuration &config)
-  : ci_(ci), config_(config)
+chimera::Consumer::Consumer(
+    CompilerInstance *ci,
+    const std::vector<const chimera::Configuration *> &configs)
+  : ci_(ci), configs_(configs)
 {
     // Do nothing.
 }
 
 void chimera::Consumer::HandleTranslationUnit(ASTContext &context)
 {
-    // Use the current translation unit to resolve the YAML configuration.
-    std::unique_ptr<chimera::CompiledConfiguration> compiled_config
-        = config_.Process(ci_);
-    chimera::Visitor visitor(ci_, *compiled_config);
+    // Each configuration is processed against the same AST, so that several
+    // modules can be generated from one parse.  The YAML is still resolved
+    // and the AST traversed once per configuration, since the declarations
+    // that are generated depend on the templates of its binding.
+    for (const chimera::Configuration *config : configs_)
+    {
+        // Use the current translation unit to resolve the YAML configuration.
+        std::unique_ptr<chimera::CompiledConfiguration> compiled_config
+            = config->Process(ci_);
+        chimera::Visitor visitor(ci_, *compiled_config);
 
-    // We can use ASTContext to get the TranslationUnitDecl, which is
-    // a single Decl that collectively represents the entire source file.
-    visitor.TraverseDecl(context.getTranslationUnitDecl());
+        // We can use ASTContext to get the TranslationUnitDecl, which is
+        // a single Decl that collectively represents the entire source file.
+        visitor.TraverseDecl(context.getTranslationUnitDecl());
 
-    // Render the top-level mstch template
-    compiled_config->Render();
+        // Render the top-level mstch template
+        compiled_config->Render();
+
+        // Record every file that the compiler loaded, since a change to any
+        // of them may change the generated bindings.
+        const SourceManager &source_manager = ci_->getSourceManager();
+        for (auto it = source_manager.fileinfo_begin();
+             it != source_manager.fileinfo_end(); ++it)
+            config->AddInputFile(it->first->getName());
+
+        config->GetStatistics().Add(
+            "wrapper arena (KiB)",
+            compiled_config->GetWrapperBytesAllocated() / 1024);
+    }
+
+    // Statistics of the AST are recorded with the first configuration, since
+    // they are shared by all of them.
+    const chimera::Configuration &config = *configs_.front();
+
+    // Record how effective the type predicate caches were, then release them
+    // since they refer to this AST context.
+    const chimera::util::TypeCacheStatistics cache_stats
+        = chimera::util::getTypeCacheStatistics(context);
+    config.GetStatistics().Add("type cache hits", cache_stats.hits);
+    config.GetStatistics().Add("type cache misses", cache_stats.misses);
+    chimera::util::clearTypeCaches(context);
+
+    // Record the memory used while the AST is still alive, along with the
+    // data that the bindings are rendered from once it has been released.
+    if (config.GetReleaseAST())
+    {
+        config.GetStatistics().Set("resident memory before release (KiB)",
+                                   chimera::getResidentMemory() / 1024);
+    }
 }
@@ -0,0 +1,235 @@
+#include "chimera/dependency_graph.h"
+#include "chimera/util.h"
+
+#include <algorithm>
+
+using namespace clang;
+
+namespace
+{
+
+bool isHard(chimera::DependencyGraph::Dependency kind)
+{
+    return kind != chimera::DependencyGraph::Dependency::Type;
+}
+
+/**
+ * Escapes a string for use as a quoted DOT identifier.
+ */
+std::string escapeDot(const std::string &str)
+{
+    std::string escaped;
+    for (const char c : str)
+    {
+        if (c == '"' || c == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+} // namespace
+
+void chimera::DependencyGraph::AddBinding(const Decl *decl,
+                                          const std::string &name)
+{
+    decl = decl->getCanonicalDecl();
+
+    // If the same declaration is rendered more than once, dependencies are
+    // tracked against the first binding.
+    binding_indices_.emplace(decl, bindings_.size());
+    bindings_.emplace_back(decl, name);
+}
+
+void chimera::DependencyGraph::AddDependency(const Decl *decl,
+                                             const Decl *dependency,
+                                             Dependency kind)
+{
+    if (!decl || !dependency)
+        return;
+
+    decl = decl->getCanonicalDecl();
+    dependency = dependency->getCanonicalDecl();
+    if (decl == dependency)
+        return;
+
+    // Keep the strongest kind of dependency between two declarations.
+    auto result = dependencies_[decl].emplace(dependency, kind);
+    if (!result.second && isHard(kind))
+        result.first->second = kind;
+}
+
+void chimera::DependencyGraph::AddTypeDependency(const Decl *decl,
+                                                 QualType type)
+{
+    if (type.isNull())
+        return;
+
+    // Strip pointers, references and arrays to find the underlying type.
+    const Type *type_ptr = type.getCanonicalType().getTypePtr();
+    while (true)
+    {
+        if (type_ptr->isAnyPointerType() || type_ptr->isReferenceType())
+            type_ptr = type_ptr->getPointeeType()
+                           .getCanonicalType()
+                           .getTypePtr();
+        else if (type_ptr->isArrayType())
+            type_ptr = type_ptr->getArrayElementTypeNoTypeQual();
+        else
+            break;
+    }
+
+    if (const auto *tag_type = type_ptr->getAs<TagType>())
+        AddDependency(decl, tag_type->getDecl(), Dependency::Type);
+}
+
+const std::set<const CXXRecordDecl *>
+    &chimera::DependencyGraph::GetBaseClassDecls(
+        const CXXRecordDecl *decl) const
+{
+    auto it = base_class_decls_.find(decl);
+    if (it == base_class_decls_.end())
+    {
+        it = base_class_decls_
+                 .emplace(decl, chimera::util::getBaseClassDecls(decl))
+                 .first;
+    }
+    return it->second;
+}
+
+std::vector<std::string> chimera::DependencyGraph::GetTopologicalOrder() const
+{
+    const std::size_t num_bindings = bindings_.size();
+    const std::vector<Edge> edges = GetEdges();
+
+    // Count the unemitted hard and soft dependencies of each binding, and
+    // keep a reverse adjacency list to update them as bindings are emitted.
+    std::vector<std::size_t> hard_pending(num_bindings, 0);
+    std::vector<std::size_t> soft_pending(num_bindings, 0);
+    std::vector<std::vector<const Edge *>> dependents(num_bindings);
+    for (const Edge &edge : edges)
+    {
+        ++(edge.hard ? hard_pending : soft_pending)[edge.from];
+        dependents[edge.to].push_back(&edge);
+    }
+
+    // Bindings whose dependencies are all emitted, and bindings whose hard
+    // dependencies are all emitted, both ordered by discovery index.
+    std::set<std::size_t> ready;
+    std::set<std::size_t> hard_ready;
+    for (std::size_t i = 0; i < num_bindings; ++i)
+    {
+        if (hard_pending[i] == 0)
+            hard_ready.insert(i);
+        if (hard_pending[i] == 0 && soft_pending[i] == 0)
+            ready.insert(i);
+    }
+
+    std::vector<bool> emitted(num_bindings, false);
+    std::vector<std::string> order;
+    order.reserve(num_bindings);
+
+    while (order.size() < num_bindings)
+    {
+        // Prefer bindings with no pending dependencies.  If there are none,
+        // there is a cycle, which is broken at the first binding with no
+        // pending hard dependencies (or the first binding, if the cycle
+        // involves hard dependencies, which should not occur).
+        std::size_t next;
+        if (!ready.empty())
+            next = *ready.begin();
+        else if (!hard_ready.empty())
+            next = *hard_ready.begin();
+        else
+        {
+            next = 0;
+            while (emitted[next])
+                ++next;
+        }
+
+        emitted[next] = true;
+        ready.erase(next);
+        hard_ready.erase(next);
+        order.push_back(bindings_[next].second);
+
+        for (const Edge *edge : dependents[next])
+        {
+            const std::size_t dependent = edge->from;
+            if (emitted[dependent])
+                continue;
+
+            if (edge->hard)
+            {
+                if (--hard_pending[dependent] == 0)
+                    hard_ready.insert(dependent);
+            }
+            else
+            {
+                --soft_pending[dependent];
+            }
+
+            if (hard_pending[dependent] == 0 && soft_pending[dependent] == 0)
+                ready.insert(dependent);
+        }
+    }
+
+    return order;
+}
+
+void chimera::DependencyGraph::WriteDot(std::ostream &os) const
+{
+    os << "digraph chimera {\n";
+    for (const auto &binding : bindings_)
+        os << "  \"" << escapeDot(binding.second) << "\";\n";
+
+    for (const Edge &edge : GetEdges())
+    {
+        os << "  \"" << escapeDot(bindings_[edge.from].second) << "\" -> \""
+           << escapeDot(bindings_[edge.to].second) << "\"";
+        if (!edge.hard)
+            os << " [style=dashed]";
+        os << ";\n";
+    }
+    os << "}\n";
+}
+
+std::size_t chimera::DependencyGraph::GetNumBindings() const
+{
+    return bindings_.size();
+}
+
+std::vector<chimera::DependencyGraph::Edge>
+chimera::DependencyGraph::GetEdges() const
+{
+    std::vector<Edge> edges;
+
+    // Iterate over bindings (rather than the dependency map) so that the
+    // edges are in a deterministic order.
+    for (std::size_t from = 0; from < bindings_.size(); ++from)
+    {
+        const auto dependencies_it = dependencies_.find(bindings_[from].first);
+        if (dependencies_it == dependencies_.end())
+            continue;
+
+        // Only the first binding of a declaration carries its dependencies.
+        if (binding_indices_.at(bindings_[from].first) != from)
+            continue;
+
+        std::vector<Edge> binding_edges;
+        for (const auto &dependency : dependencies_it->second)
+        {
+            const auto to_it = binding_indices_.find(dependency.first);
+            if (to_it == binding_indices_.end())
+                continue;
+
+            binding_edges.push_back(
+                Edge{from, to_it->second, isHard(dependency.second)});
+        }
+
+        std::sort(binding_edges.begin(), binding_edges.end(),
+                  [](const Edge &a, const Edge &b) { return a.to < b.to; });
+        edges.insert(edges.end(), binding_edges.begin(), binding_edges.end());
+    }
+
+    return edges;
+}
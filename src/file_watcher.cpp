@@ -0,0 +1,148 @@
+#include "chimera/file_watcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+chimera::FileWatcher::FileWatcher() : fd_(-1)
+{
+#ifdef __linux__
+    fd_ = inotify_init1(IN_CLOEXEC);
+    if (fd_ < 0)
+    {
+        throw std::runtime_error("Failed to watch files: "
+                                 + std::string(strerror(errno)));
+    }
+#else
+    throw std::runtime_error("Watching files is only supported on Linux.");
+#endif
+}
+
+chimera::FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+}
+
+void chimera::FileWatcher::SetPaths(const std::set<std::string> &paths)
+{
+#ifdef __linux__
+    // Directories that are still watched keep their descriptor, so that the
+    // changes recorded for them are not lost.
+    std::string error;
+    std::map<int, std::string> directories;
+    std::set<std::string> watched_directories;
+    paths_.clear();
+    for (const std::string &path : paths)
+    {
+        llvm::SmallString<256> absolute_path(path);
+        llvm::sys::fs::make_absolute(absolute_path);
+        llvm::sys::path::remove_dots(absolute_path, true);
+        paths_.insert(absolute_path.str().str());
+
+        const std::string directory
+            = llvm::sys::path::parent_path(absolute_path).str();
+        if (!watched_directories.insert(directory).second)
+            continue;
+
+        const int wd = inotify_add_watch(
+            fd_, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+        if (wd < 0)
+        {
+            if (error.empty())
+            {
+                std::stringstream ss;
+                ss << "Failed to watch directory '" << directory
+                   << "': " << strerror(errno);
+                error = ss.str();
+            }
+            continue;
+        }
+        directories[wd] = directory;
+    }
+
+    for (const auto &directory : directories_)
+        if (!directories.count(directory.first))
+            inotify_rm_watch(fd_, directory.first);
+    directories_.swap(directories);
+
+    if (!error.empty())
+        throw std::runtime_error(error);
+#else
+    (void)paths;
+#endif
+}
+
+std::set<std::string> chimera::FileWatcher::Wait(
+    std::chrono::milliseconds debounce, std::chrono::milliseconds timeout)
+{
+    std::set<std::string> changed_paths;
+#ifdef __linux__
+    while (true)
+    {
+        // Wait for the first change until the timeout, and then only as long
+        // as further changes keep coming.
+        pollfd poll_fd;
+        poll_fd.fd = fd_;
+        poll_fd.events = POLLIN;
+        poll_fd.revents = 0;
+        const int ready = ::poll(
+            &poll_fd, 1,
+            static_cast<int>(changed_paths.empty() ? timeout.count()
+                                                   : debounce.count()));
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to watch files: "
+                                     + std::string(strerror(errno)));
+        }
+        if (ready == 0)
+            break;
+
+        alignas(inotify_event) char buffer[4096];
+        const ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+        if (length < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to watch files: "
+                                     + std::string(strerror(errno)));
+        }
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event *event
+                = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0)
+                continue;
+
+            const auto directory = directories_.find(event->wd);
+            if (directory == directories_.end())
+                continue;
+
+            const std::string path = directory->second + "/" + event->name;
+            if (paths_.count(path))
+                changed_paths.insert(path);
+        }
+    }
+#else
+    (void)debounce;
+    (void)timeout;
+#endif
+    return changed_paths;
+}
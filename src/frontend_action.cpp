@@ -1,36 +1,109 @@
 #include "chimera/frontend_action.h"
 #include "chimera/consumer.h"
 
+#include <clang/Basic/SourceManager.h>
+#include <clang/Frontend/MultiplexConsumer.h>
 #include <clang/Parse/Parser.h>
 
 using namespace clang;
 
-chimera::FrontendAction::FrontendAction(const chimera::Configuration &config)
-  : config_(config)
+namespace
+{
+
+/**
+ * Exposes the consumer that serializes the AST of a translation unit, which
+ * is what `clang -emit-ast` uses.
+ */
+class EmitASTAction : public clang::GeneratePCHAction
+{
+public:
+    using clang::GeneratePCHAction::CreateASTConsumer;
+};
+
+} // namespace
+
+chimera::FrontendAction::FrontendAction(
+    const std::vector<const chimera::Configuration *> &configs,
+    chimera::ASTCache *ast_cache, bool *handled)
+  : configs_(configs), ast_cache_(ast_cache), handled_(handled)
 {
     // Do nothing.
 }
 
 std::unique_ptr<clang::ASTConsumer> chimera::FrontendAction::CreateASTConsumer(
-    CompilerInstance &CI, StringRef /*file*/)
+    CompilerInstance &CI, StringRef file)
 {
     // For some unknown reason, this is called twice, which should be once.
-    // As a workaround, we check if this called first, otherwise return nullptr.
-    static bool is_first = true;
-    if (!is_first)
-        return nullptr;
+    // As a workaround, we check if this called first in the run, otherwise
+    // return nullptr.
+    if (handled_)
+    {
+        if (*handled_)
+            return nullptr;
+        *handled_ = true;
+    }
 
-    is_first = false;
+    // The compiler normally leaks its AST on exit to save time.  When asked
+    // to release the AST before rendering the bindings, it must be freed.
+    for (const chimera::Configuration *config : configs_)
+        if (config->GetReleaseAST())
+            CI.getFrontendOpts().DisableFree = false;
 
     CI.getPreprocessor().getDiagnostics().setIgnoreAllWarnings(true);
-    return std::unique_ptr<chimera::Consumer>(
-        new chimera::Consumer(&CI, config_));
+    std::unique_ptr<ASTConsumer> consumer(
+        new chimera::Consumer(&CI, configs_));
+
+    // Save the AST of a parsed source alongside running chimera on it, so
+    // that later runs can load it instead.
+    if (!ast_cache_ || isCurrentFileAST()
+        || CI.getFrontendOpts().OutputFile.empty())
+        return consumer;
+
+    // The AST cache compares the content of the files that the AST was
+    // parsed from, so their modification times are left out of the AST.
+    // Otherwise, loading it would fail once any of them was merely touched.
+    CI.getFrontendOpts().IncludeTimestamps = false;
+    std::unique_ptr<ASTConsumer> emitter
+        = EmitASTAction().CreateASTConsumer(CI, file);
+    if (!emitter)
+        return consumer;
+
+    ast_path_ = CI.getFrontendOpts().OutputFile;
+    std::vector<std::unique_ptr<ASTConsumer>> consumers;
+    consumers.push_back(std::move(emitter));
+    consumers.push_back(std::move(consumer));
+    return std::unique_ptr<ASTConsumer>(
+        new MultiplexConsumer(std::move(consumers)));
+}
+
+void chimera::FrontendAction::EndSourceFileAction()
+{
+    if (ast_path_.empty())
+        return;
+
+    // Record the files that the saved AST was parsed from, including any
+    // precompiled header that it depends on.
+    const CompilerInstance &CI = getCompilerInstance();
+    std::vector<std::string> input_files;
+    const SourceManager &source_manager = CI.getSourceManager();
+    for (auto it = source_manager.fileinfo_begin();
+         it != source_manager.fileinfo_end(); ++it)
+        input_files.push_back(it->first->tryGetRealPathName().empty()
+                                  ? it->first->getName().str()
+                                  : it->first->tryGetRealPathName().str());
+    const std::string &pch_path = CI.getPreprocessorOpts().ImplicitPCHInclude;
+    if (!pch_path.empty())
+        input_files.push_back(pch_path);
+
+    ast_cache_->AddSavedAST(ast_path_, input_files);
+    ast_path_.clear();
 }
 
 // Create a custom action factory that forwards the ChimeraConfiguration.
 chimera::ChimeraFrontendActionFactory::ChimeraFrontendActionFactory(
-    const chimera::Configuration &config)
-  : config_(config)
+    const std::vector<const chimera::Configuration *> &configs,
+    chimera::ASTCache *ast_cache)
+  : configs_(configs), ast_cache_(ast_cache), handled_(false)
 {
     // Do nothing.
 }
@@ -41,18 +114,20 @@ chimera::ChimeraFrontendActionFactory::ChimeraFrontendActionFactory(
 std::unique_ptr<FrontendAction> chimera::ChimeraFrontendActionFactory::create()
 {
     return std::unique_ptr<FrontendAction>(
-        new chimera::FrontendAction(config_));
+        new chimera::FrontendAction(configs_, ast_cache_, &handled_));
 }
 #else
 FrontendAction *chimera::ChimeraFrontendActionFactory::create()
 {
-    return new chimera::FrontendAction(config_);
+    return new chimera::FrontendAction(configs_, ast_cache_, &handled_);
 }
 #endif
 
 std::unique_ptr<tooling::FrontendActionFactory>
-chimera::newFrontendActionFactory(const chimera::Configuration &config)
+chimera::newFrontendActionFactory(
+    const std::vector<const chimera::Configuration *> &configs,
+    chimera::ASTCache *ast_cache)
 {
     return std::unique_ptr<tooling::FrontendActionFactory>(
-        new chimera::ChimeraFrontendActionFactory(config));
+        new chimera::ChimeraFrontendActionFactory(configs, ast_cache));
 }
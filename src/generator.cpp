@@ -0,0 +1,683 @@
+#include "chimera/generator.h"
+#include "chimera/ast_cache.h"
+#include "chimera/file_watcher.h"
+#include "chimera/frontend_action.h"
+#include "chimera/precompiled_header.h"
+#include "chimera/server.h"
+#include "chimera/util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+using namespace clang;
+using namespace clang::tooling;
+
+namespace
+{
+
+/**
+ * Returns the configurations as the list that the consumer takes.
+ */
+std::vector<const chimera::Configuration *> getPointers(
+    const std::vector<std::unique_ptr<chimera::Configuration>> &configs)
+{
+    std::vector<const chimera::Configuration *> pointers;
+    for (const auto &config : configs)
+        pointers.push_back(config.get());
+    return pointers;
+}
+
+/**
+ * Returns the bindings to generate, paired with their output directories.
+ * The bindings are either given by name or listed in the YAML configuration.
+ * A single named binding is written to the output path itself.
+ */
+std::vector<std::pair<std::string, std::string>> getBindings(
+    const std::vector<std::string> &binding_names, const YAML::Node &root,
+    const std::string &output_path)
+{
+    const auto join = [&output_path](const std::string &path) {
+        return llvm::sys::path::is_absolute(path) ? path
+                                                  : output_path + "/" + path;
+    };
+
+    std::vector<std::pair<std::string, std::string>> bindings;
+    if (binding_names.size() == 1)
+        bindings.emplace_back(binding_names.front(), output_path);
+    else if (!binding_names.empty())
+        for (const std::string &name : binding_names)
+            bindings.emplace_back(name, join(name));
+    else if (const YAML::Node node = root["binding"])
+    {
+        if (node.IsSequence())
+        {
+            for (const YAML::Node &name : node)
+                bindings.emplace_back(name.as<std::string>(),
+                                      join(name.as<std::string>()));
+        }
+        else if (node.IsMap())
+        {
+            for (const auto &entry : node)
+                bindings.emplace_back(entry.first.as<std::string>(),
+                                      join(entry.second.as<std::string>()));
+        }
+    }
+    return bindings;
+}
+
+} // namespace
+
+chimera::ModuleOptions chimera::parseModuleSpec(const std::string &spec)
+{
+    chimera::ModuleOptions module;
+    std::stringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ','))
+    {
+        const std::size_t separator = field.find('=');
+        const std::string key = field.substr(0, separator);
+        const std::string value = separator == std::string::npos
+                                      ? std::string()
+                                      : field.substr(separator + 1);
+        if (value.empty())
+        {
+            std::stringstream ss;
+            ss << "Module option '" << field << "' in '" << spec
+               << "' has no value.";
+            throw std::invalid_argument(ss.str());
+        }
+
+        if (key == "binding")
+            module.binding_names.push_back(value);
+        else if (key == "name")
+            module.module_name = value;
+        else if (key == "output")
+            module.output_path = value;
+        else if (key == "config")
+            module.config_filename = value;
+        else if (key == "namespace")
+            module.namespace_names.push_back(value);
+        else if (key == "depfile")
+            module.depfile_path = value;
+        else
+        {
+            std::stringstream ss;
+            ss << "Unknown module option '" << key << "' in '" << spec
+               << "'.";
+            throw std::invalid_argument(ss.str());
+        }
+    }
+    return module;
+}
+
+void chimera::parseShardSpec(const std::string &spec, unsigned &index,
+                             unsigned &count)
+{
+    std::stringstream ss(spec);
+    char separator = 0;
+    if (!(ss >> index >> separator >> count) || separator != '/'
+        || !ss.eof() || count == 0 || index >= count)
+    {
+        std::stringstream message;
+        message << "Shard '" << spec
+                << "' must be of the form 'index/count', with an index less "
+                << "than the count.";
+        throw std::invalid_argument(message.str());
+    }
+}
+
+chimera::Generator::Generator(const CompilationDatabase &compilations,
+                              const std::vector<std::string> &source_paths,
+                              const GeneratorOptions &options)
+  : compilations_(compilations), source_paths_(source_paths), options_(options)
+{
+    // Do nothing.
+}
+
+std::vector<std::unique_ptr<chimera::Configuration>>
+chimera::Generator::CreateConfigurations() const
+{
+    std::vector<ModuleOptions> modules = options_.modules;
+    if (modules.empty())
+        modules.push_back(ModuleOptions());
+
+    std::vector<std::unique_ptr<chimera::Configuration>> configs;
+    std::set<std::string> output_paths;
+    std::set<std::string> depfile_paths;
+    for (const ModuleOptions &module : modules)
+    {
+        std::unique_ptr<chimera::Configuration> config(
+            new chimera::Configuration());
+        Configure(*config, module);
+
+        // Each binding gets its own configuration, which only differs in the
+        // binding name and the output path.  If no bindings are listed, the
+        // binding is resolved by the configuration as usual.
+        const std::vector<std::pair<std::string, std::string>> bindings
+            = getBindings(module.binding_names.empty() ? options_.binding_names
+                                                       : module.binding_names,
+                          config->GetRoot(), config->GetOutputPath());
+        std::vector<std::unique_ptr<chimera::Configuration>> module_configs;
+        for (const auto &binding : bindings)
+        {
+            if (module_configs.empty())
+                module_configs.push_back(std::move(config));
+            else
+            {
+                // The YAML configuration is only read once per module.
+                module_configs.emplace_back(new chimera::Configuration());
+                Configure(*module_configs.back(), module,
+                          module_configs.front().get());
+                module_configs.back()->SetDepfile("", "");
+            }
+            module_configs.back()->SetBindingName(binding.first);
+            module_configs.back()->SetOutputPath(binding.second);
+        }
+        if (module_configs.empty())
+            module_configs.push_back(std::move(config));
+
+        // Declarations are written to files named after them, and each module
+        // removes the files that it no longer generates, so modules that share
+        // an output directory would overwrite and remove each other's files.
+        for (const auto &module_config : module_configs)
+        {
+            llvm::SmallString<256> output_path(module_config->GetOutputPath());
+            llvm::sys::fs::make_absolute(output_path);
+            llvm::sys::path::remove_dots(output_path, true);
+            if (!output_paths.insert(output_path.str().str()).second)
+            {
+                std::stringstream ss;
+                ss << "Several modules are generated into '"
+                   << module_config->GetOutputPath()
+                   << "', but each needs its own output directory.";
+                throw std::invalid_argument(ss.str());
+            }
+        }
+
+        const std::string depfile_path = module.depfile_path.empty()
+                                              ? options_.depfile_path
+                                              : module.depfile_path;
+        if (!depfile_path.empty() && !depfile_paths.insert(depfile_path).second)
+        {
+            std::stringstream ss;
+            ss << "Several modules write the depfile '" << depfile_path
+               << "'.";
+            throw std::invalid_argument(ss.str());
+        }
+
+        for (auto &module_config : module_configs)
+            configs.push_back(std::move(module_config));
+    }
+    return configs;
+}
+
+void chimera::Generator::Configure(chimera::Configuration &config,
+                                   const ModuleOptions &module,
+                                   const chimera::Configuration *loaded) const
+{
+    // The options of the module take precedence over the shared ones.
+    const auto choose = [](const std::string &module_value,
+                           const std::string &value) -> const std::string & {
+        return module_value.empty() ? value : module_value;
+    };
+
+    // Parse the YAML configuration file if it exists, otherwise initialize it
+    // to an empty node.  If another configuration of the module already
+    // loaded it, share its YAML instead.
+    const std::string &config_filename
+        = choose(module.config_filename, options_.config_filename);
+    if (loaded)
+        config.SetRoot(loaded->GetRoot(), loaded->GetConfigFilename());
+    else if (!config_filename.empty())
+        config.LoadFile(config_filename);
+
+    // If an output path was specified, set configuration to use it.
+    const std::string &output_path
+        = choose(module.output_path, options_.output_path);
+    if (!output_path.empty())
+        config.SetOutputPath(output_path);
+
+    // If a top-level binding file was specified, set configuration to use it.
+    const std::string &module_name
+        = choose(module.module_name, options_.module_name);
+    if (!module_name.empty())
+        config.SetOutputModuleName(module_name);
+
+    // Add top-level namespaces to the configuration.
+    for (const std::string &name : module.namespace_names.empty()
+                                       ? options_.namespace_names
+                                       : module.namespace_names)
+        config.AddInputNamespaceName(name);
+
+    // Add compilation source paths to the configuration.
+    // These will be made available to templates.
+    if (!options_.suppress_sources)
+        for (const std::string &path : source_paths_)
+            config.AddSourcePath(path);
+
+    // If strict option is on, treats unresolvable configuration as errors.
+    if (options_.strict)
+        config.SetStrict(true);
+
+    // If a dependency graph path was specified, export the graph to it.
+    if (!options_.dependency_graph_path.empty())
+        config.SetDependencyGraphPath(options_.dependency_graph_path);
+
+    // If the AST should be released before rendering, defer the bindings.
+    if (options_.release_ast)
+        config.SetReleaseAST(true);
+
+    // If unity sources were requested, merge binding sources into them.
+    if (options_.unity_file_count > 0)
+        config.SetUnityFileCount(options_.unity_file_count);
+
+    // If several jobs were requested, render the bindings on that many threads.
+    if (options_.jobs > 1)
+        config.SetRenderThreadCount(options_.jobs);
+
+    // If a write queue was requested, write the bindings in the background.
+    if (options_.write_queue_size > 0)
+        config.SetWriteQueueSize(options_.write_queue_size);
+
+    // If a class split threshold was specified, split large classes.
+    if (options_.class_split_threshold > 0)
+        config.SetClassSplitThreshold(options_.class_split_threshold);
+
+    // If minimal includes were requested, resolve them for each binding.
+    if (options_.minimal_includes)
+        config.SetMinimalIncludes(true);
+
+    // If a prefix header was requested, render it with the module.
+    if (options_.prefix_header)
+        config.SetPrefixHeader(true);
+
+    // If only the outputs should be listed, skip writing them.
+    if (options_.list_outputs)
+        config.SetListOutputs(true);
+
+    // If a depfile path was specified, write the dependencies to it.
+    const std::string &depfile_path
+        = choose(module.depfile_path, options_.depfile_path);
+    if (!depfile_path.empty())
+        config.SetDepfile(depfile_path, module.depfile_path.empty()
+                                            ? options_.depfile_target
+                                            : std::string());
+
+    // Set the layout of the generated bindings in the output directory.
+    config.SetOutputLayout(options_.output_layout);
+
+    // If a shard was specified, only render its bindings.
+    if (options_.shard_count > 1)
+        config.SetShard(options_.shard_index, options_.shard_count);
+}
+
+void chimera::Generator::Finish(const chimera::Configuration &config) const
+{
+    if (options_.list_outputs)
+        return;
+
+    // A shard leaves the clean up of the output directory to the merge,
+    // which knows the outputs of all shards.
+    if (config.IsSharded())
+        config.WriteShardListing();
+    else
+        config.RemoveStaleOutputs();
+}
+
+ArgumentsAdjuster chimera::Generator::GetArgumentsAdjuster() const
+{
+    // Add or suppress clang documentation flag as specified, and add the
+    // appropriate C/C++ language flag.
+    return combineAdjusters(
+        getInsertArgumentAdjuster(options_.suppress_docs ? "-Wno-documentation"
+                                                         : "-Wdocumentation",
+                                  ArgumentInsertPosition::BEGIN),
+        getInsertArgumentAdjuster(options_.use_c_mode ? "-xc" : "-xc++",
+                                  ArgumentInsertPosition::BEGIN));
+}
+
+int chimera::Generator::Run(
+    const std::vector<std::unique_ptr<chimera::Configuration>> &configs)
+{
+    // Statistics and inputs of the parse are recorded with the first module,
+    // since they are shared by all of them.
+    chimera::Configuration &config = *configs.front();
+
+    // Create tool that uses the sources and their compile commands.
+    ClangTool tool(compilations_, source_paths_);
+    tool.appendArgumentsAdjuster(GetArgumentsAdjuster());
+
+    // Look up the cached ASTs and precompiled headers of each compile
+    // command, so that the command can be adjusted to use them.
+    const bool use_ast_cache = !options_.ast_cache_path.empty();
+    const bool use_pch
+        = !options_.pch_cache_path.empty() && !options_.pch_includes.empty();
+    const std::string docs_flag
+        = options_.suppress_docs ? "-Wno-documentation" : "-Wdocumentation";
+    const std::string language = options_.use_c_mode ? "c" : "c++";
+    chimera::ASTCache ast_cache(options_.ast_cache_path);
+    chimera::PrecompiledHeaderCache pch_cache(options_.pch_cache_path,
+                                              options_.pch_includes);
+    std::map<std::string, std::pair<CompileCommand, std::string>> ast_paths;
+    std::map<std::string, std::string> saved_ast_paths;
+    std::map<std::string, std::string> pch_paths;
+    if (use_ast_cache || use_pch)
+    {
+        std::vector<std::string> key_args = {docs_flag, "-x" + language};
+        if (use_pch)
+            for (const std::string &header : options_.pch_includes)
+                key_args.push_back("-pch-include=" + header);
+
+        for (const std::string &path : source_paths_)
+        {
+            llvm::SmallString<256> absolute_path(path);
+            llvm::sys::fs::make_absolute(absolute_path);
+            for (const CompileCommand &command :
+                 compilations_.getCompileCommands(absolute_path))
+            {
+                if (use_ast_cache)
+                {
+                    std::string ast_path;
+                    if (ast_cache.Find(command, key_args, ast_path))
+                    {
+                        ast_paths[command.Filename]
+                            = std::make_pair(command, ast_path);
+                        continue;
+                    }
+                    saved_ast_paths[command.Filename] = ast_path;
+                }
+
+                if (use_pch)
+                {
+                    const std::string pch_path
+                        = pch_cache.Get(command, {docs_flag}, language);
+                    if (!pch_path.empty())
+                        pch_paths[command.Filename] = pch_path;
+                }
+            }
+        }
+
+        for (const auto &module_config : configs)
+        {
+            for (const std::string &path : ast_cache.GetInputFiles())
+                module_config->AddInputFile(path);
+            for (const std::string &path : pch_cache.GetInputFiles())
+                module_config->AddInputFile(path);
+        }
+        if (use_ast_cache)
+            config.GetStatistics().Set("cached ASTs loaded",
+                                       ast_cache.GetNumFound());
+        if (use_pch)
+            config.GetStatistics().Set("precompiled headers built",
+                                       pch_cache.GetNumBuilt());
+
+        tool.appendArgumentsAdjuster(
+            [ast_paths, saved_ast_paths, pch_paths](
+                const CommandLineArguments &args,
+                StringRef filename) -> CommandLineArguments {
+                CommandLineArguments adjusted(args);
+
+                // Load a cached AST in place of the source.
+                const auto ast = ast_paths.find(filename.str());
+                if (ast != ast_paths.end())
+                {
+                    for (std::string &argument : adjusted)
+                        if (chimera::util::isInputArgument(argument,
+                                                           ast->second.first))
+                            argument = ast->second.second;
+                    const auto input = std::find(adjusted.begin(),
+                                                 adjusted.end(),
+                                                 ast->second.second);
+                    adjusted.insert(input, {"-x", "ast"});
+                    return adjusted;
+                }
+
+                // Save the AST of the source as it is parsed.
+                const auto saved = saved_ast_paths.find(filename.str());
+                if (saved != saved_ast_paths.end())
+                    adjusted.insert(adjusted.begin() + 1,
+                                    {"-Xclang", "-o", "-Xclang",
+                                     saved->second});
+
+                // Include the precompiled prefix header.  The cache compares
+                // the content of the files that it was built from, so clang
+                // does not need to validate them again.
+                const auto pch = pch_paths.find(filename.str());
+                if (pch != pch_paths.end())
+                    adjusted.insert(adjusted.begin() + 1,
+                                    {"-include-pch", pch->second, "-Xclang",
+                                     "-fno-validate-pch"});
+                return adjusted;
+            });
+    }
+
+    // Run the instantiated tool on the Chimera frontend.
+    const int result = tool.run(
+        chimera::newFrontendActionFactory(
+            getPointers(configs), use_ast_cache ? &ast_cache : nullptr)
+            .get());
+
+    // Make the ASTs that were saved available to later runs.
+    ast_cache.Commit();
+
+    // By now the compiler instances and their ASTs have been destroyed, so
+    // the bindings are rendered from the data that was extracted for them,
+    // with the memory of the AST returned to the OS.
+    if (options_.release_ast)
+    {
+        chimera::releaseFreeMemory();
+        config.GetStatistics().Set("resident memory after release (KiB)",
+                                   chimera::getResidentMemory() / 1024);
+        for (const auto &module_config : configs)
+            module_config->RenderDeferredOutputs();
+    }
+
+    config.GetStatistics().Set("peak resident memory (KiB)",
+                               chimera::getPeakResidentMemory() / 1024);
+
+    for (const auto &module_config : configs)
+    {
+        // Wait for the bindings that are still being written in the
+        // background, which reports any of them that failed.
+        module_config->GetOutputWriter().Flush();
+        module_config->WriteDepfile();
+
+        // Only clean up the output directory after a complete run, since the
+        // outputs of a failed run are incomplete.
+        if (result == 0)
+            Finish(*module_config);
+
+        module_config->GetStatistics().Set(
+            "files written", module_config->GetOutputWriter().GetNumWritten());
+        module_config->GetStatistics().Set(
+            "files unchanged",
+            module_config->GetOutputWriter().GetNumUnchanged());
+    }
+
+    return result;
+}
+
+void chimera::Generator::Merge(
+    const std::vector<std::unique_ptr<chimera::Configuration>> &configs,
+    unsigned shard_count)
+{
+    for (const auto &config : configs)
+    {
+        config->MergeShards(shard_count);
+        config->WriteDepfile();
+        config->RemoveStaleOutputs();
+    }
+}
+
+void chimera::Generator::Serve(const std::string &socket_path,
+                               const std::string &key)
+{
+    chimera::IncrementalParser parser(compilations_, source_paths_,
+                                      GetArgumentsAdjuster(),
+                                      GetResourcePath());
+
+    std::cerr << "Chimera is listening on '" << socket_path << "'."
+              << std::endl;
+    chimera::serve(socket_path, [&](const std::string &request) {
+        if (request != "generate " + key)
+            return std::string("mismatch\n");
+
+        std::stringstream response;
+        std::stringstream output;
+        std::streambuf *stdout_buffer = std::cout.rdbuf(output.rdbuf());
+        try
+        {
+            const std::vector<std::unique_ptr<chimera::Configuration>> configs
+                = CreateConfigurations();
+            Regenerate(parser, configs);
+
+            std::cout.rdbuf(stdout_buffer);
+            std::string line;
+            while (std::getline(output, line))
+                response << "out " << line << "\n";
+            for (const auto &config : configs)
+                for (const std::string &path :
+                     config->GetOutputWriter().GetChangedPaths())
+                    response << "changed " << path << "\n";
+        }
+        catch (const std::exception &e)
+        {
+            std::cout.rdbuf(stdout_buffer);
+            response << "error " << e.what() << "\n";
+        }
+        return response.str();
+    });
+}
+
+void chimera::Generator::Watch()
+{
+    chimera::IncrementalParser parser(compilations_, source_paths_,
+                                      GetArgumentsAdjuster(),
+                                      GetResourcePath());
+
+    // The watcher records changes for as long as it exists, so it is armed
+    // before each regeneration to notice the files that change meanwhile.
+    chimera::FileWatcher watcher;
+    const auto arm = [&watcher](const std::set<std::string> &paths,
+                                bool report) {
+        try
+        {
+            watcher.SetPaths(paths);
+            return true;
+        }
+        catch (const std::exception &e)
+        {
+            if (report)
+                std::cerr << e.what() << std::endl;
+            return false;
+        }
+    };
+
+    std::vector<std::unique_ptr<chimera::Configuration>> configs;
+    arm(GetWatchedFiles(configs, parser), true);
+    while (true)
+    {
+        configs.clear();
+        try
+        {
+            configs = CreateConfigurations();
+            Regenerate(parser, configs);
+            for (const auto &config : configs)
+                for (const std::string &path :
+                     config->GetOutputWriter().GetChangedPaths())
+                    std::cerr << "Updated " << path << "\n";
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+
+        // Watch everything that the bindings were generated from, which may
+        // have changed along with the sources.
+        const std::set<std::string> input_files
+            = GetWatchedFiles(configs, parser);
+        bool armed = arm(input_files, true);
+        std::cerr << "Watching " << input_files.size()
+                  << " files for changes." << std::endl;
+
+        // Editors and version control often write several files in quick
+        // succession, so wait for them to settle before regenerating.  Files
+        // that could not be watched, for example because their directory was
+        // removed, are retried every second, and regenerated from once they
+        // can be watched again.
+        std::set<std::string> changed_files;
+        while (true)
+        {
+            const std::chrono::milliseconds retry(armed ? -1 : 1000);
+            changed_files = watcher.Wait(std::chrono::milliseconds(200), retry);
+            if (!changed_files.empty())
+                break;
+            armed = arm(input_files, false);
+            if (armed)
+                break;
+        }
+        for (const std::string &path : changed_files)
+            std::cerr << "Changed " << path << "\n";
+    }
+}
+
+std::set<std::string> chimera::Generator::GetWatchedFiles(
+    const std::vector<std::unique_ptr<chimera::Configuration>> &configs,
+    const chimera::IncrementalParser &parser) const
+{
+    // The configuration and sources are watched even if generation failed
+    // before their dependencies were known.
+    std::set<std::string> input_files;
+    for (const auto &config : configs)
+        for (const std::string &path : config->GetInputFiles())
+            input_files.insert(path);
+    for (const std::string &path : parser.GetInputFiles())
+        input_files.insert(path);
+    for (const std::string &path : source_paths_)
+        input_files.insert(path);
+    if (!options_.config_filename.empty())
+        input_files.insert(options_.config_filename);
+    for (const ModuleOptions &module : options_.modules)
+        if (!module.config_filename.empty())
+            input_files.insert(module.config_filename);
+    return input_files;
+}
+
+std::string chimera::Generator::GetResourcePath() const
+{
+    // The resource directory with the builtin headers is found relative to
+    // the executable, which is located through an address within it.
+    static int anchor;
+    return CompilerInvocation::GetResourcesPath("chimera", &anchor);
+}
+
+void chimera::Generator::Regenerate(
+    chimera::IncrementalParser &parser,
+    const std::vector<std::unique_ptr<chimera::Configuration>> &configs) const
+{
+    // The configurations are created for every run by the caller, since they
+    // may have changed along with the sources.
+    if (!parser.Parse())
+        throw std::runtime_error("Failed to parse the sources.");
+    parser.Run(getPointers(configs));
+
+    // The parser keeps its AST for the next run, so bindings that were
+    // deferred until its release are rendered right away.
+    for (const auto &config : configs)
+    {
+        config->RenderDeferredOutputs();
+        config->GetOutputWriter().Flush();
+        config->WriteDepfile();
+        Finish(*config);
+    }
+}
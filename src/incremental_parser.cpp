@@ -0,0 +1,131 @@
+#include "chimera/incremental_parser.h"
+#include "chimera/consumer.h"
+#include "chimera/util.h"
+
+#include <iostream>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/PCHContainerOperations.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+
+using namespace clang;
+using namespace clang::tooling;
+
+chimera::IncrementalParser::IncrementalParser(
+    const CompilationDatabase &compilations,
+    const std::vector<std::string> &source_paths,
+    const ArgumentsAdjuster &adjuster, const std::string &resource_path)
+  : resource_path_(resource_path)
+  , pch_container_ops_(std::make_shared<PCHContainerOperations>())
+{
+    // Adjust the compile commands the same way as ClangTool does.
+    const ArgumentsAdjuster command_adjuster = combineAdjusters(
+        combineAdjusters(getClangSyntaxOnlyAdjuster(),
+                         getClangStripOutputAdjuster()),
+        combineAdjusters(getClangStripDependencyFileAdjuster(), adjuster));
+
+    for (const std::string &path : source_paths)
+    {
+        llvm::SmallString<256> absolute_path(path);
+        llvm::sys::fs::make_absolute(absolute_path);
+        for (const CompileCommand &command :
+             compilations.getCompileCommands(absolute_path))
+        {
+            CommandLineArguments command_line
+                = command_adjuster(command.CommandLine, command.Filename);
+
+            // Resolve relative paths against the directory of the command,
+            // which ClangTool would otherwise change into.
+            command_line.insert(command_line.begin() + 1,
+                                {"-working-directory", command.Directory});
+            command_lines_.push_back(command_line);
+        }
+    }
+}
+
+bool chimera::IncrementalParser::Parse()
+{
+    if (!units_.empty())
+    {
+        // Reparsing reuses the preamble of each source if possible.
+        bool success = true;
+        for (const auto &unit : units_)
+        {
+            if (unit->Reparse(pch_container_ops_))
+            {
+                std::cerr << "Failed to reparse '"
+                          << unit->getMainFileName().str() << "'."
+                          << std::endl;
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    for (const std::vector<std::string> &command_line : command_lines_)
+    {
+        std::vector<const char *> args;
+        for (const std::string &argument : command_line)
+            args.push_back(argument.c_str());
+
+        IntrusiveRefCntPtr<DiagnosticsEngine> diagnostics
+            = CompilerInstance::createDiagnostics(new DiagnosticOptions());
+        diagnostics->setIgnoreAllWarnings(true);
+
+        std::unique_ptr<ASTUnit> unit(ASTUnit::LoadFromCommandLine(
+            args.data(), args.data() + args.size(), pch_container_ops_,
+            diagnostics, resource_path_, /* OnlyLocalDecls = */ false,
+#if LLVM_VERSION_AT_LEAST(10, 0, 0)
+            CaptureDiagsKind::None,
+#else
+            /* CaptureDiagnostics = */ false,
+#endif
+            /* RemappedFiles = */ {}, /* RemappedFilesKeepOriginalName = */ true,
+            /* PrecompilePreambleAfterNParses = */ 1));
+        if (!unit || diagnostics->hasFatalErrorOccurred())
+        {
+            units_.clear();
+            return false;
+        }
+        units_.push_back(std::move(unit));
+    }
+    return true;
+}
+
+void chimera::IncrementalParser::Run(
+    const std::vector<const chimera::Configuration *> &configs)
+{
+    // Like a regular run, only the first translation unit is handled.
+    if (units_.empty())
+        return;
+    const std::unique_ptr<ASTUnit> &unit = units_.front();
+
+    // Present the parsed translation unit as a compiler instance, which is
+    // what chimera expects, without handing over its ownership.
+    CompilerInstance ci;
+    *ci.getInvocation().getLangOpts() = unit->getLangOpts();
+    ci.setFileManager(&unit->getFileManager());
+    ci.setSourceManager(&unit->getSourceManager());
+    ci.setPreprocessor(unit->getPreprocessorPtr());
+    ci.setASTContext(&unit->getASTContext());
+    ci.setSema(&unit->getSema());
+
+    chimera::Consumer consumer(&ci, configs);
+    consumer.HandleTranslationUnit(unit->getASTContext());
+
+    ci.takeSema().release();
+}
+
+std::vector<std::string> chimera::IncrementalParser::GetInputFiles() const
+{
+    std::vector<std::string> input_files;
+    for (const auto &unit : units_)
+    {
+        const SourceManager &source_manager = unit->getSourceManager();
+        for (auto it = source_manager.fileinfo_begin();
+             it != source_manager.fileinfo_end(); ++it)
+            input_files.push_back(it->first->getName());
+    }
+    return input_files;
+}
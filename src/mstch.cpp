@@ -3,7 +3,9 @@
 #include "chimera/util.h"
 #include "cling_utils_AST.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <unordered_set>
 #include <vector>
@@ -29,7 +31,7 @@ namespace mstch
             {
                 NamespaceDecl *parent_decl
                     = nns->getAsNamespace()->getCanonicalDecl();
-                auto ns = std::make_shared<Namespace>(config, parent_decl);
+                auto ns = config.MakeWrapper<Namespace>(parent_decl);
                 if (!ns->nameAsString().empty())
                     scope_templates.push_back(ns);
                 break;
@@ -94,7 +96,7 @@ namespace mstch
                     throw std::runtime_error(
                         "TypeSpec was not a CXXRecordDecl.");
                 auto cxx_record
-                    = std::make_shared<CXXRecord>(config, parent_decl);
+                    = config.MakeWrapper<CXXRecord>(parent_decl);
                 if (!cxx_record->nameAsString().empty())
                     scope_templates.push_back(cxx_record);
                 break;
@@ -154,7 +156,7 @@ namespace mstch
             {
                 NamespaceDecl *parent_decl
                     = nns->getAsNamespace()->getCanonicalDecl();
-                auto ns = std::make_shared<Namespace>(config, parent_decl);
+                auto ns = config.MakeWrapper<Namespace>(parent_decl);
                 if (!ns->nameAsString().empty())
                     scope_templates.push_back(ns);
                 break;
@@ -167,7 +169,7 @@ namespace mstch
                     throw std::runtime_error(
                         "TypeSpec was not a CXXRecordDecl.");
                 auto cxx_record
-                    = std::make_shared<CXXRecord>(config, parent_decl);
+                    = config.MakeWrapper<CXXRecord>(parent_decl);
                 if (!cxx_record->nameAsString().empty())
                     scope_templates.push_back(cxx_record);
                 break;
@@ -216,7 +218,11 @@ namespace mstch
 CXXRecord::CXXRecord(const ::chimera::CompiledConfiguration &config,
                      const CXXRecordDecl *decl,
                      const std::set<const CXXRecordDecl *> *available_decls)
-  : ClangWrapper(config, decl), available_decls_(available_decls)
+  : ClangWrapper(config, decl)
+  , available_decls_(available_decls)
+  , method_begin_(0)
+  , method_end_(std::numeric_limits<std::size_t>::max())
+  , part_count_(0)
 {
     register_methods(
         this,
@@ -242,17 +248,19 @@ CXXRecord::CXXRecord(const ::chimera::CompiledConfiguration &config,
             {"static_fields", &CXXRecord::staticFields},
             {"static_fields?",
              &CXXRecord::isNonFalse<CXXRecord, &CXXRecord::staticFields>},
+            {"parts", &CXXRecord::parts},
+            {"parts?", &CXXRecord::isNonFalse<CXXRecord, &CXXRecord::parts>},
         });
 }
 
 ::mstch::node CXXRecord::bases()
 {
-    if (const YAML::Node node = decl_config_["bases"])
-        return chimera::util::wrapYAMLNode(node);
+    if (decl_config_.bases)
+        return chimera::util::wrapYAMLNode(decl_config_.bases);
 
     // Get all bases of this class.
     std::set<const CXXRecordDecl *> base_decls
-        = chimera::util::getBaseClassDecls(decl_);
+        = config_.GetDependencyGraph().GetBaseClassDecls(decl_);
 
     // If a list of available decls is provided, only use available base
     // classes.
@@ -274,7 +282,7 @@ CXXRecord::CXXRecord(const ::chimera::CompiledConfiguration &config,
     std::vector<std::shared_ptr<CXXRecord>> base_vector;
     for (const auto *base_decl : base_decls)
     {
-        base_vector.push_back(std::make_shared<CXXRecord>(config_, base_decl));
+        base_vector.push_back(config_.MakeWrapper<CXXRecord>(base_decl));
     }
 
     // Find and flag the last item.
@@ -284,6 +292,7 @@ CXXRecord::CXXRecord(const ::chimera::CompiledConfiguration &config,
 
     // Copy each template into the mstch template array.
     ::mstch::array base_templates;
+    base_templates.reserve(base_vector.size());
     for (auto base_template : base_vector)
         base_templates.push_back(base_template);
     return base_templates;
@@ -300,8 +309,8 @@ CXXRecord::CXXRecord(const ::chimera::CompiledConfiguration &config,
 
 std::string CXXRecord::typeAsString()
 {
-    if (const YAML::Node node = decl_config_["type"])
-        return node.as<std::string>();
+    if (decl_config_.type)
+        return *decl_config_.type;
 
     return chimera::util::getFullyQualifiedTypeName(
         config_.GetContext(), QualType(decl_->getTypeForDecl(), 0));
@@ -332,24 +341,24 @@ std::string CXXRecord::typeAsString()
 
 ::mstch::node CXXRecord::isCopyable()
 {
-    if (const YAML::Node node = decl_config_["is_copyable"])
-        return node.as<bool>();
+    if (decl_config_.is_copyable)
+        return *decl_config_.is_copyable;
 
     return chimera::util::isCopyable(decl_);
 }
 
 ::std::string CXXRecord::nameAsString()
 {
-    if (const YAML::Node node = decl_config_["name"])
-        return node.as<std::string>();
+    if (decl_config_.name)
+        return *decl_config_.name;
 
     return chimera::util::constructBindingName(decl_);
 }
 
 ::mstch::node CXXRecord::qualifiedName()
 {
-    if (const YAML::Node node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     // In the special case of CXXRecords, the fully-qualified name of the
     // class is pretty much always identical to the type declaration. Since
@@ -403,7 +412,7 @@ std::string CXXRecord::typeAsString()
             continue;
 
         constructor_vector.push_back(
-            std::make_shared<Method>(config_, method_decl, decl_));
+            config_.MakeWrapper<Method>(method_decl, decl_));
     }
 
     // Find and flag the last item.
@@ -412,12 +421,26 @@ std::string CXXRecord::typeAsString()
         constructor_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    constructor_templates.reserve(constructor_vector.size());
     for (auto constructor_template : constructor_vector)
         constructor_templates.push_back(constructor_template);
     return constructor_templates;
 }
 
 ::mstch::node CXXRecord::methods()
+{
+    const ::mstch::array non_static_methods = instanceMethods();
+    if (method_begin_ == 0 && method_end_ >= non_static_methods.size())
+        return non_static_methods;
+
+    // Only return the methods in the range registered by this part.
+    const std::size_t end = std::min(method_end_, non_static_methods.size());
+    const std::size_t begin = std::min(method_begin_, end);
+    return ::mstch::array(non_static_methods.begin() + begin,
+                          non_static_methods.begin() + end);
+}
+
+::mstch::array CXXRecord::instanceMethods() const
 {
     const ::mstch::array method_templates
         = boost::get<::mstch::array>(methodsInternal());
@@ -461,8 +484,7 @@ std::string CXXRecord::typeAsString()
 
     // Copy each non-static method into the mstch template.
     std::unordered_set<std::string> non_static_method_names;
-    const ::mstch::array non_static_method_templates
-        = boost::get<::mstch::array>(methods());
+    const ::mstch::array non_static_method_templates = instanceMethods();
     for (const ::mstch::node &method_node : non_static_method_templates)
     {
         const auto method
@@ -509,7 +531,7 @@ std::string CXXRecord::typeAsString()
             continue;
 
         field_vector.push_back(
-            std::make_shared<Field>(config_, field_decl, decl_));
+            config_.MakeWrapper<Field>(field_decl, decl_));
     }
 
     // Find and flag the last item.
@@ -518,6 +540,7 @@ std::string CXXRecord::typeAsString()
         field_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    field_templates.reserve(field_vector.size());
     for (auto field_template : field_vector)
         field_templates.push_back(field_template);
     return field_templates;
@@ -549,7 +572,7 @@ std::string CXXRecord::typeAsString()
             continue;
 
         static_field_vector.push_back(
-            std::make_shared<Variable>(config_, static_field_decl, decl_));
+            config_.MakeWrapper<Variable>(static_field_decl, decl_));
     }
 
     // Find and flag the last item.
@@ -558,6 +581,7 @@ std::string CXXRecord::typeAsString()
         static_field_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    static_field_templates.reserve(static_field_vector.size());
     for (auto static_field_template : static_field_vector)
         static_field_templates.push_back(static_field_template);
     return static_field_templates;
@@ -565,6 +589,11 @@ std::string CXXRecord::typeAsString()
 
 ::mstch::node CXXRecord::methodsInternal() const
 {
+    // The method list backs several template properties, so it is generated
+    // once per class rather than on every evaluation.
+    if (methods_)
+        return *methods_;
+
     ::mstch::array method_templates;
 
     // Convert each method to a template object.
@@ -619,7 +648,7 @@ std::string CXXRecord::typeAsString()
             continue;
 
         // Generate the method wrapper (but don't add it just yet).
-        auto method = std::make_shared<Method>(config_, method_decl, decl_);
+        auto method = config_.MakeWrapper<Method>(method_decl, decl_);
 
         // Check if a return_value_policy can be generated for this function.
         if (::mstch::render("{{return_value_policy}}", method).empty()
@@ -641,11 +670,75 @@ std::string CXXRecord::typeAsString()
         method_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    method_templates.reserve(method_vector.size());
     for (auto method_template : method_vector)
         method_templates.push_back(method_template);
+
+    methods_ = method_templates;
     return method_templates;
 }
 
+::mstch::node CXXRecord::parts()
+{
+    ::mstch::array part_templates;
+    part_templates.reserve(part_count_);
+    for (std::size_t index = 1; index <= part_count_; ++index)
+        part_templates.push_back(
+            ::mstch::map{{"index", static_cast<int>(index)}});
+    return part_templates;
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> CXXRecord::splitMethods(
+    std::size_t max_overloads) const
+{
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+    // Greedily fill each range with consecutive methods, so that methods with
+    // the same name stay close together in the generated files.
+    const ::mstch::array non_static_methods = instanceMethods();
+    std::size_t begin = 0;
+    std::size_t num_overloads = 0;
+    for (std::size_t i = 0; i < non_static_methods.size(); ++i)
+    {
+        const auto method = std::dynamic_pointer_cast<Method>(
+            boost::get<std::shared_ptr<::mstch::object>>(
+                non_static_methods[i]));
+        const auto arg_range
+            = chimera::util::getFunctionArgumentRange(method->getDecl());
+        const std::size_t method_overloads
+            = 1 + arg_range.second - arg_range.first;
+
+        if (i > begin && num_overloads + method_overloads > max_overloads)
+        {
+            ranges.emplace_back(begin, i);
+            begin = i;
+            num_overloads = 0;
+        }
+        num_overloads += method_overloads;
+    }
+    if (begin < non_static_methods.size())
+        ranges.emplace_back(begin, non_static_methods.size());
+
+    return ranges;
+}
+
+void CXXRecord::setMethodRange(std::size_t begin, std::size_t end,
+                               std::size_t part_count)
+{
+    method_begin_ = begin;
+    method_end_ = end;
+    part_count_ = part_count;
+}
+
+std::shared_ptr<CXXRecord> CXXRecord::createPart(std::size_t begin,
+                                                 std::size_t end) const
+{
+    auto part = config_.MakeWrapper<CXXRecord>(decl_, available_decls_);
+    part->methods_ = methods_; // share the method list that is already built
+    part->setMethodRange(begin, end);
+    return part;
+}
+
 Enum::Enum(const ::chimera::CompiledConfiguration &config, const EnumDecl *decl)
   : ClangWrapper(config, decl)
 {
@@ -657,8 +750,8 @@ Enum::Enum(const ::chimera::CompiledConfiguration &config, const EnumDecl *decl)
 
 ::mstch::node Enum::qualifiedName()
 {
-    if (const YAML::Node node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     // In the special case of Enums, the fully-qualified name of the
     // class is pretty much always identical to the type declaration. Since
@@ -696,8 +789,8 @@ Enum::Enum(const ::chimera::CompiledConfiguration &config, const EnumDecl *decl)
 
 ::mstch::node Enum::type()
 {
-    if (const YAML::Node &node = decl_config_["type"])
-        return node.as<std::string>();
+    if (decl_config_.type)
+        return *decl_config_.type;
 
     return chimera::util::getFullyQualifiedDeclTypeAsString(decl_);
 }
@@ -714,7 +807,7 @@ Enum::Enum(const ::chimera::CompiledConfiguration &config, const EnumDecl *decl)
         if (config_.IsSuppressed(constant_decl))
             continue;
         constant_vector.push_back(
-            std::make_shared<EnumConstant>(config_, constant_decl, decl_));
+            config_.MakeWrapper<EnumConstant>(constant_decl, decl_));
     }
 
     // Find and flag the last item.
@@ -723,6 +816,7 @@ Enum::Enum(const ::chimera::CompiledConfiguration &config, const EnumDecl *decl)
         constant_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    constant_templates.reserve(constant_vector.size());
     for (auto constant_template : constant_vector)
         constant_templates.push_back(constant_template);
     return constant_templates;
@@ -738,13 +832,13 @@ EnumConstant::EnumConstant(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node EnumConstant::qualifiedName()
 {
-    if (const YAML::Node &node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     // In the special case of EnumConstants, rather than letting clang try to
     // fully resolve the qualified name, we can simply get it from appending
     // this value to the parent Enum's qualified name.
-    auto enumeration = std::make_shared<Enum>(config_, enum_decl_);
+    auto enumeration = config_.MakeWrapper<Enum>(enum_decl_);
     return ::mstch::render("{{type}}", enumeration)
            + "::" + decl_->getNameAsString();
 }
@@ -763,16 +857,16 @@ Field::Field(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Field::isAssignable()
 {
-    if (const YAML::Node &node = decl_config_["is_assignable"])
-        return node.as<std::string>();
+    if (decl_config_.is_assignable)
+        return *decl_config_.is_assignable;
 
     return chimera::util::isAssignable(config_.GetContext(), decl_->getType());
 }
 
 ::mstch::node Field::isCopyable()
 {
-    if (const YAML::Node &node = decl_config_["is_copyable"])
-        return node.as<std::string>();
+    if (decl_config_.is_copyable)
+        return *decl_config_.is_copyable;
 
     return chimera::util::isCopyable(config_.GetContext(), decl_->getType());
 }
@@ -780,8 +874,8 @@ Field::Field(const ::chimera::CompiledConfiguration &config,
 ::mstch::node Field::returnValuePolicy()
 {
     // First, check if a return_value_policy was specified for this function.
-    if (const YAML::Node &node = decl_config_["return_value_policy"])
-        return node.as<std::string>();
+    if (decl_config_.return_value_policy)
+        return *decl_config_.return_value_policy;
 
     // Extract the value type of this field declaration.
     const QualType value_qual_type = chimera::util::getFullyQualifiedType(
@@ -798,8 +892,8 @@ Field::Field(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Field::qualifiedName()
 {
-    if (const YAML::Node &node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     return chimera::util::getFullyQualifiedDeclTypeAsString(class_decl_)
            + "::" + decl_->getNameAsString();
@@ -837,8 +931,8 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Function::type()
 {
-    if (const YAML::Node &node = decl_config_["type"])
-        return node.as<std::string>();
+    if (decl_config_.type)
+        return *decl_config_.type;
 
     QualType pointer_type;
     if (class_decl_ && !cast<CXXMethodDecl>(decl_)->isStatic())
@@ -865,7 +959,7 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
     for (unsigned n_args = arg_range.first; n_args < arg_range.second; ++n_args)
     {
         overloads.push_back(
-            std::make_shared<Function>(config_, decl_, class_decl_, n_args));
+            config_.MakeWrapper<Function>(decl_, class_decl_, n_args));
     }
 
     // Add this function to its own list of overloads.
@@ -898,8 +992,8 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
 
         // Create a parameter template and add it to the parameter array.
         const ParmVarDecl *param_decl = decl_->getParamDecl(param_idx);
-        param_vector.push_back(std::make_shared<Parameter>(
-            config_, param_decl, decl_, class_decl_, ss.str()));
+        param_vector.push_back(config_.MakeWrapper<Parameter>(
+            param_decl, decl_, class_decl_, ss.str()));
     }
 
     // Find and flag the last item.
@@ -908,6 +1002,7 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
         param_vector.back()->setLast(true);
 
     // Copy each template into the mstch template array.
+    param_templates.reserve(param_vector.size());
     for (auto param_template : param_vector)
         param_templates.push_back(param_template);
     return param_templates;
@@ -916,8 +1011,8 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
 ::mstch::node Function::returnType()
 {
     // First, check if a return_value_policy was specified for this function.
-    if (const YAML::Node &node = decl_config_["return_type"])
-        return node.as<std::string>();
+    if (decl_config_.return_type)
+        return *decl_config_.return_type;
 
     // Extract the return type of this function declaration.
     return chimera::util::getFullyQualifiedTypeName(config_.GetContext(),
@@ -927,8 +1022,8 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
 ::mstch::node Function::returnValuePolicy()
 {
     // First, check if a return_value_policy was specified for this function.
-    if (const YAML::Node &node = decl_config_["return_value_policy"])
-        return node.as<std::string>();
+    if (decl_config_.return_value_policy)
+        return *decl_config_.return_value_policy;
 
     // Extract the return type of this function declaration.
     const QualType return_qual_type = chimera::util::getFullyQualifiedType(
@@ -946,8 +1041,8 @@ Function::Function(const ::chimera::CompiledConfiguration &config,
 ::mstch::node Function::isVoid()
 {
     // First, check if a return_value_policy was specified for this function.
-    if (const YAML::Node &node = decl_config_["return_type"])
-        return (node.as<std::string>() == "void");
+    if (decl_config_.return_type)
+        return (*decl_config_.return_type == "void");
 
     return decl_->getReturnType()->isVoidType();
 }
@@ -980,8 +1075,8 @@ std::string Function::nameAsString()
 
 ::mstch::node Function::qualifiedName()
 {
-    if (const YAML::Node &node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     if (!class_decl_)
         return decl_->getQualifiedNameAsString();
@@ -997,8 +1092,8 @@ std::string Function::nameAsString()
 
 ::mstch::node Function::qualifiedCall()
 {
-    if (const YAML::Node &node = decl_config_["qualified_call"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_call)
+        return *decl_config_.qualified_call;
 
     const auto template_str = chimera::util::getTemplateParameterString(
         decl_, config_.GetBindingName());
@@ -1013,8 +1108,8 @@ std::string Function::nameAsString()
 
 ::mstch::node Function::call()
 {
-    if (const YAML::Node &node = decl_config_["call"])
-        return node.as<std::string>();
+    if (decl_config_.call)
+        return *decl_config_.call;
 
     return decl_->getNameAsString()
            + chimera::util::getTemplateParameterString(
@@ -1094,8 +1189,8 @@ Parameter::Parameter(const ::chimera::CompiledConfiguration &config,
 
 ::std::string Parameter::nameAsString()
 {
-    if (const YAML::Node &node = decl_config_["name"])
-        return node.as<std::string>();
+    if (decl_config_.name)
+        return *decl_config_.name;
 
     // Ignore argument is part of a variadic function
     // (since it could be non-unique).
@@ -1110,8 +1205,8 @@ Parameter::Parameter(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Parameter::type()
 {
-    if (const YAML::Node &node = decl_config_["type"])
-        return node.as<std::string>();
+    if (decl_config_.type)
+        return *decl_config_.type;
 
     auto type_str = chimera::util::getFullyQualifiedTypeName(
         config_.GetContext(), decl_->getType());
@@ -1135,8 +1230,8 @@ Variable::Variable(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Variable::qualifiedName()
 {
-    if (const YAML::Node &node = decl_config_["qualified_name"])
-        return node.as<std::string>();
+    if (decl_config_.qualified_name)
+        return *decl_config_.qualified_name;
 
     if (!class_decl_)
         return decl_->getQualifiedNameAsString();
@@ -1162,8 +1257,8 @@ Variable::Variable(const ::chimera::CompiledConfiguration &config,
 
 ::mstch::node Variable::isAssignable()
 {
-    if (const YAML::Node &node = decl_config_["is_assignable"])
-        return node.as<std::string>();
+    if (decl_config_.is_assignable)
+        return *decl_config_.is_assignable;
 
     return chimera::util::isAssignable(config_.GetContext(), decl_->getType());
 }
@@ -1208,7 +1303,7 @@ Typedef::Typedef(const CompiledConfiguration &config,
 
 ::mstch::node Typedef::underlyingClass()
 {
-    return std::make_shared<CXXRecord>(config_, class_decl_);
+    return config_.MakeWrapper<CXXRecord>(class_decl_);
 }
 
 ::mstch::node Typedef::isBuiltinType()
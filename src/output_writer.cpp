@@ -0,0 +1,263 @@
+#include "chimera/output_writer.h"
+
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+chimera::OutputWriter::OutputWriter()
+  : num_written_(0)
+  , num_unchanged_(0)
+  , queue_size_(0)
+  , writing_(false)
+  , stopping_(false)
+{
+    // Do nothing.
+}
+
+chimera::OutputWriter::~OutputWriter()
+{
+    // Let the background thread write the files that are still queued, since
+    // each of them replaces its output atomically.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queue_filled_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void chimera::OutputWriter::SetQueueSize(std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_size_ = size;
+}
+
+bool chimera::OutputWriter::Write(const std::string &path,
+                                  const std::string &content)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    paths_.push_back(path);
+
+    if (queue_size_ > 0)
+    {
+        Enqueue(lock, path, content);
+        return true;
+    }
+
+    lock.unlock();
+    return !WriteFile(path, content);
+}
+
+void chimera::OutputWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_drained_.wait(lock, [this]() { return queue_.empty() && !writing_; });
+    if (!error_.empty())
+    {
+        std::string error;
+        error.swap(error_);
+        throw std::runtime_error(error);
+    }
+}
+
+std::size_t chimera::OutputWriter::GetNumWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_written_;
+}
+
+std::size_t chimera::OutputWriter::GetNumUnchanged() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return num_unchanged_;
+}
+
+const std::vector<std::string> &chimera::OutputWriter::GetChangedPaths() const
+{
+    return changed_paths_;
+}
+
+const std::vector<std::string> &chimera::OutputWriter::GetPaths() const
+{
+    return paths_;
+}
+
+void chimera::OutputWriter::Keep(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    paths_.push_back(path);
+}
+
+std::vector<std::string> chimera::OutputWriter::UpdateManifest(
+    const std::string &manifest_path)
+{
+    const std::string directory
+        = llvm::sys::path::parent_path(manifest_path).str();
+    const std::string prefix = directory.empty() ? "" : directory + "/";
+
+    // Collect the paths written by this run relative to the manifest.
+    std::set<std::string> relative_paths;
+    for (const std::string &path : paths_)
+    {
+        if (!prefix.empty() && path.compare(0, prefix.size(), prefix) == 0)
+            relative_paths.insert(path.substr(prefix.size()));
+        else
+            relative_paths.insert(path);
+    }
+
+    // Remove the files from the previous run that were not written again.
+    std::vector<std::string> removed_paths;
+    auto previous = llvm::MemoryBuffer::getFile(manifest_path);
+    if (previous)
+    {
+        llvm::SmallVector<llvm::StringRef, 64> previous_paths;
+        (*previous)->getBuffer().split(previous_paths, '\n', -1, false);
+        for (const llvm::StringRef previous_path : previous_paths)
+        {
+            if (relative_paths.count(previous_path.str()))
+                continue;
+
+            const std::string path = prefix + previous_path.str();
+            if (!llvm::sys::fs::remove(path, /* IgnoreNonExisting = */ false))
+                removed_paths.push_back(path);
+        }
+    }
+
+    std::stringstream manifest;
+    for (const std::string &relative_path : relative_paths)
+        manifest << relative_path << "\n";
+
+    bool changed;
+    if (std::error_code ec
+        = ReplaceFile(manifest_path, manifest.str(), changed))
+    {
+        std::stringstream ss;
+        ss << "Failed to create manifest '" << manifest_path
+           << "': " << ec.message();
+        throw std::runtime_error(ss.str());
+    }
+
+    return removed_paths;
+}
+
+void chimera::OutputWriter::Enqueue(std::unique_lock<std::mutex> &lock,
+                                    const std::string &path,
+                                    const std::string &content)
+{
+    if (!thread_.joinable())
+        thread_ = std::thread(&chimera::OutputWriter::WriteQueue, this);
+
+    // Hold back the renderer while the queue is full, which bounds the memory
+    // taken by rendered files that have not been written yet.
+    queue_drained_.wait(lock,
+                        [this]() { return queue_.size() < queue_size_; });
+    queue_.emplace_back(path, content);
+    queue_filled_.notify_one();
+}
+
+void chimera::OutputWriter::WriteQueue()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        queue_filled_.wait(lock,
+                           [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            break;
+
+        const std::pair<std::string, std::string> file
+            = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+        queue_drained_.notify_all();
+
+        lock.unlock();
+        const std::error_code ec = WriteFile(file.first, file.second);
+        lock.lock();
+
+        if (ec && error_.empty())
+        {
+            std::stringstream ss;
+            ss << "Failed to create output file '" << file.first
+               << "': " << ec.message();
+            error_ = ss.str();
+        }
+        writing_ = false;
+        queue_drained_.notify_all();
+    }
+}
+
+std::error_code chimera::OutputWriter::WriteFile(const std::string &path,
+                                                 const std::string &content)
+{
+    bool changed;
+    if (std::error_code ec = ReplaceFile(path, content, changed))
+        return ec;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (changed)
+    {
+        ++num_written_;
+        changed_paths_.push_back(path);
+    }
+    else
+        ++num_unchanged_;
+    return std::error_code();
+}
+
+std::error_code chimera::OutputWriter::ReplaceFile(const std::string &path,
+                                                   const std::string &content,
+                                                   bool &changed)
+{
+    // Leave the existing file alone if it already has the same content.
+    changed = false;
+    auto existing = llvm::MemoryBuffer::getFile(path);
+    if (existing && (*existing)->getBuffer() == content)
+        return std::error_code();
+
+    // Write the content to a temporary file next to the output file, then
+    // rename it over the output file, so that readers never see a partially
+    // written file.
+    // Create the directory of the output file if it is in a subdirectory.
+    const llvm::StringRef directory = llvm::sys::path::parent_path(path);
+    if (!directory.empty())
+    {
+        if (std::error_code ec = llvm::sys::fs::create_directories(directory))
+            return ec;
+    }
+
+    int fd;
+    llvm::SmallString<256> temp_path;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(
+            path + "-%%%%%%%%.tmp", fd, temp_path))
+        return ec;
+
+    {
+        llvm::raw_fd_ostream stream(fd, /* shouldClose = */ true);
+        stream << content;
+        stream.close();
+        if (stream.has_error())
+        {
+            stream.clear_error();
+            llvm::sys::fs::remove(temp_path);
+            return std::make_error_code(std::errc::io_error);
+        }
+    }
+
+    if (std::error_code ec = llvm::sys::fs::rename(temp_path, path))
+    {
+        llvm::sys::fs::remove(temp_path);
+        return ec;
+    }
+
+    changed = true;
+    return std::error_code();
+}
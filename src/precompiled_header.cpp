@@ -0,0 +1,290 @@
+#include "chimera/precompiled_header.h"
+#include "chimera/output_writer.h"
+#include "chimera/util.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Basic/Version.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Tooling/ArgumentsAdjusters.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+using namespace clang;
+using namespace clang::tooling;
+
+namespace
+{
+
+/**
+ * Compiles the input of a compiler instance into a precompiled header at a
+ * given path, and records the files that it was built from.
+ */
+class GeneratePCHFileAction : public clang::GeneratePCHAction
+{
+public:
+    GeneratePCHFileAction(const std::string &output_path,
+                          std::vector<std::string> &input_files)
+      : output_path_(output_path), input_files_(input_files)
+    {
+        // Do nothing.
+    }
+
+    bool BeginInvocation(CompilerInstance &CI) override
+    {
+        CI.getFrontendOpts().OutputFile = output_path_;
+
+        // Leave out the modification times of the input files, so that the
+        // cached ASTs that include the header can still be loaded after any
+        // of them was merely touched.
+        CI.getFrontendOpts().IncludeTimestamps = false;
+        return true;
+    }
+
+    void EndSourceFileAction() override
+    {
+        const SourceManager &source_manager
+            = getCompilerInstance().getSourceManager();
+        for (auto it = source_manager.fileinfo_begin();
+             it != source_manager.fileinfo_end(); ++it)
+            input_files_.push_back(it->first->getName());
+
+        clang::GeneratePCHAction::EndSourceFileAction();
+    }
+
+private:
+    const std::string output_path_;
+    std::vector<std::string> &input_files_;
+};
+
+class GeneratePCHFileActionFactory : public FrontendActionFactory
+{
+public:
+    GeneratePCHFileActionFactory(const std::string &output_path,
+                                 std::vector<std::string> &input_files)
+      : output_path_(output_path), input_files_(input_files)
+    {
+        // Do nothing.
+    }
+
+// Between Clang 9 and Clang 10, the return value for
+// FrontendActionFactory::create() changed from raw pointer to std::unique_ptr.
+#if LLVM_VERSION_AT_LEAST(10, 0, 0)
+    std::unique_ptr<FrontendAction> create() override
+    {
+        return std::unique_ptr<FrontendAction>(
+            new GeneratePCHFileAction(output_path_, input_files_));
+    }
+#else
+    FrontendAction *create() override
+    {
+        return new GeneratePCHFileAction(output_path_, input_files_);
+    }
+#endif
+
+private:
+    const std::string output_path_;
+    std::vector<std::string> &input_files_;
+};
+
+/**
+ * Compilation database that returns a single compile command for any file.
+ */
+class SingleCommandDatabase : public CompilationDatabase
+{
+public:
+    explicit SingleCommandDatabase(const CompileCommand &command)
+      : command_(command)
+    {
+        // Do nothing.
+    }
+
+    std::vector<CompileCommand> getCompileCommands(
+        llvm::StringRef /*file_path*/) const override
+    {
+        return {command_};
+    }
+
+private:
+    const CompileCommand command_;
+};
+
+} // namespace
+
+chimera::PrecompiledHeaderCache::PrecompiledHeaderCache(
+    const std::string &directory, const std::vector<std::string> &includes)
+  : directory_(directory), includes_(includes), num_built_(0)
+{
+    // Do nothing.
+}
+
+std::string chimera::PrecompiledHeaderCache::Get(
+    const CompileCommand &command, const std::vector<std::string> &arguments,
+    const std::string &language)
+{
+    // Ignore the output and dependency file arguments, which differ between
+    // sources that could otherwise share a precompiled header.
+    CommandLineArguments command_line = command.CommandLine;
+    command_line
+        = getClangStripOutputAdjuster()(command_line, command.Filename);
+    command_line = getClangStripDependencyFileAdjuster()(command_line,
+                                                         command.Filename);
+
+    // Generate the prefix header, which includes files directly by path if
+    // they exist and through the include paths otherwise.
+    std::stringstream header;
+    for (const std::string &include : includes_)
+    {
+        llvm::SmallString<256> path(include);
+        if (llvm::sys::fs::is_regular_file(path))
+        {
+            llvm::sys::fs::make_absolute(path);
+            header << "#include \"" << path.str().str() << "\"\n";
+        }
+        else
+            header << "#include <" << include << ">\n";
+    }
+
+    // Key the precompiled header by everything that affects its content
+    // except for the content of the files that it includes, which is checked
+    // separately so that the key is known before the header is compiled.
+    std::stringstream key;
+    key << clang::getClangFullVersion() << "\n"
+        << language << "\n"
+        << command.Directory << "\n"
+        << header.str();
+    for (const std::string &argument : arguments)
+        key << argument << "\n";
+    for (const std::string &argument : command_line)
+        if (!chimera::util::isInputArgument(argument, command))
+            key << argument << "\n";
+
+    std::stringstream stem;
+    stem << std::hex << std::setfill('0') << std::setw(16)
+         << chimera::util::stableHash(key.str());
+    llvm::SmallString<256> header_path(directory_);
+    llvm::sys::path::append(header_path, stem.str() + ".h");
+    llvm::sys::fs::make_absolute(header_path);
+    const std::string pch_path = header_path.str().str() + ".pch";
+
+    if (IsUpToDate(pch_path))
+        return pch_path;
+
+    chimera::OutputWriter writer;
+    if (!writer.Write(header_path.str(), header.str()))
+    {
+        std::cerr << "Warning: Unable to write prefix header '"
+                  << header_path.str().str() << "'." << std::endl;
+        return "";
+    }
+
+    // Compile the prefix header in place of the input of the command, with
+    // the same arguments as the sources that will use it.
+    CompileCommand pch_command = command;
+    pch_command.Filename = header_path.str();
+    pch_command.CommandLine.clear();
+    bool has_input = false;
+    for (const std::string &argument : command_line)
+    {
+        if (chimera::util::isInputArgument(argument, command))
+        {
+            pch_command.CommandLine.push_back(header_path.str());
+            has_input = true;
+        }
+        else
+            pch_command.CommandLine.push_back(argument);
+    }
+    if (!has_input || pch_command.CommandLine.empty())
+    {
+        std::cerr << "Warning: Unable to find the input of the compile "
+                  << "command for '" << command.Filename
+                  << "', so no precompiled header is used." << std::endl;
+        return "";
+    }
+
+    CommandLineArguments prefix_arguments = arguments;
+    prefix_arguments.push_back("-x" + language + "-header");
+    pch_command.CommandLine.insert(pch_command.CommandLine.begin() + 1,
+                                   prefix_arguments.begin(),
+                                   prefix_arguments.end());
+
+    if (!Build(pch_command, header_path.str(), pch_path))
+        return "";
+    return pch_path;
+}
+
+const std::vector<std::string> &
+chimera::PrecompiledHeaderCache::GetInputFiles() const
+{
+    return input_files_;
+}
+
+std::size_t chimera::PrecompiledHeaderCache::GetNumBuilt() const
+{
+    return num_built_;
+}
+
+bool chimera::PrecompiledHeaderCache::IsUpToDate(const std::string &pch_path)
+{
+    if (!llvm::sys::fs::exists(pch_path))
+        return false;
+
+    // The precompiled header can be reused if none of the files that it was
+    // built from have changed.
+    std::vector<std::string> input_files;
+    if (!chimera::util::readFileHashes(pch_path + ".inputs", input_files))
+        return false;
+
+    input_files_.insert(input_files_.end(), input_files.begin(),
+                        input_files.end());
+    return true;
+}
+
+bool chimera::PrecompiledHeaderCache::Build(const CompileCommand &command,
+                                            const std::string &header_path,
+                                            const std::string &pch_path)
+{
+    llvm::sys::fs::remove(pch_path);
+    llvm::sys::fs::remove(pch_path + ".inputs");
+
+    std::vector<std::string> input_files;
+    SingleCommandDatabase database(command);
+    ClangTool tool(database, {header_path});
+    GeneratePCHFileActionFactory factory(pch_path, input_files);
+    if (tool.run(&factory) != 0 || !llvm::sys::fs::exists(pch_path))
+    {
+        std::cerr << "Warning: Unable to build precompiled header '"
+                  << pch_path << "'." << std::endl;
+        llvm::sys::fs::remove(pch_path);
+        return false;
+    }
+
+    // Record the content hashes of the files that the precompiled header was
+    // built from, which decide whether later runs can reuse it.
+    std::vector<std::string> absolute_input_files;
+    for (const std::string &input_file : input_files)
+    {
+        llvm::SmallString<256> path(input_file);
+        llvm::sys::fs::make_absolute(command.Directory, path);
+        llvm::sys::path::remove_dots(path, true);
+        absolute_input_files.push_back(path.str());
+    }
+    input_files_.insert(input_files_.end(), absolute_input_files.begin(),
+                        absolute_input_files.end());
+
+    if (!chimera::util::writeFileHashes(pch_path + ".inputs",
+                                        absolute_input_files))
+    {
+        std::cerr << "Warning: Unable to record the inputs of precompiled "
+                  << "header '" << pch_path << "'." << std::endl;
+    }
+
+    ++num_built_;
+    return true;
+}
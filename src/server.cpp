@@ -0,0 +1,221 @@
+#include "chimera/server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Writing to a socket whose peer has disconnected must fail rather than
+// raise SIGPIPE, which would kill the server.
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+/**
+ * Fills in the address of a local UNIX socket.  Returns false if the path
+ * does not fit in the address.
+ */
+bool getSocketAddress(const std::string &socket_path, sockaddr_un &address)
+{
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+        return false;
+    std::strncpy(address.sun_path, socket_path.c_str(),
+                 sizeof(address.sun_path) - 1);
+    return true;
+}
+
+/**
+ * Creates a local UNIX socket that does not raise SIGPIPE.
+ */
+int createSocket()
+{
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+#ifdef SO_NOSIGPIPE
+    if (fd >= 0)
+    {
+        const int enable = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+    }
+#endif
+    return fd;
+}
+
+/**
+ * Returns true if a server accepts connections on a local UNIX socket.
+ */
+bool isListening(const sockaddr_un &address)
+{
+    const int fd = createSocket();
+    if (fd < 0)
+        return false;
+    const bool connected
+        = ::connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                    sizeof(address))
+          == 0;
+    ::close(fd);
+    return connected;
+}
+
+/**
+ * Reads from a socket until a newline or the end of the stream.
+ */
+std::string readLine(int fd)
+{
+    std::string line;
+    char c;
+    while (true)
+    {
+        const ssize_t count = ::read(fd, &c, 1);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0 || c == '\n')
+            break;
+        line += c;
+    }
+    return line;
+}
+
+/**
+ * Reads from a socket until the end of the stream.
+ */
+std::string readAll(int fd)
+{
+    std::string content;
+    char buffer[4096];
+    while (true)
+    {
+        const ssize_t count = ::read(fd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            break;
+        content.append(buffer, count);
+    }
+    return content;
+}
+
+/**
+ * Writes all of a string to a socket.
+ */
+bool writeAll(int fd, const std::string &content)
+{
+    std::size_t offset = 0;
+    while (offset < content.size())
+    {
+        const ssize_t count = ::send(fd, content.data() + offset,
+                                     content.size() - offset, SEND_FLAGS);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            return false;
+        offset += count;
+    }
+    return true;
+}
+
+} // namespace
+
+void chimera::serve(
+    const std::string &socket_path,
+    const std::function<std::string(const std::string &)> &handler)
+{
+    sockaddr_un address;
+    if (!getSocketAddress(socket_path, address))
+    {
+        std::stringstream ss;
+        ss << "Socket path '" << socket_path << "' is too long.";
+        throw std::runtime_error(ss.str());
+    }
+
+    // Replace the socket of a previous server that was not shut down, but
+    // neither another file nor the socket of a server that still runs.
+    struct stat status;
+    if (::lstat(socket_path.c_str(), &status) == 0)
+    {
+        std::stringstream ss;
+        if (!S_ISSOCK(status.st_mode))
+            ss << "'" << socket_path << "' exists and is not a socket.";
+        else if (isListening(address))
+            ss << "A server is already listening on '" << socket_path << "'.";
+        if (!ss.str().empty())
+            throw std::runtime_error(ss.str());
+        ::unlink(socket_path.c_str());
+    }
+
+    const int fd = createSocket();
+    if (fd < 0)
+        throw std::runtime_error("Failed to create socket: "
+                                 + std::string(strerror(errno)));
+
+    if (::bind(fd, reinterpret_cast<const sockaddr *>(&address),
+               sizeof(address))
+            < 0
+        || ::listen(fd, 8) < 0)
+    {
+        std::stringstream ss;
+        ss << "Failed to listen on socket '" << socket_path
+           << "': " << strerror(errno);
+        ::close(fd);
+        throw std::runtime_error(ss.str());
+    }
+
+    while (true)
+    {
+        const int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        const std::string line = readLine(client);
+        if (line == "stop")
+        {
+            ::close(client);
+            break;
+        }
+
+        writeAll(client, handler(line));
+        ::close(client);
+    }
+
+    ::close(fd);
+    ::unlink(socket_path.c_str());
+}
+
+bool chimera::request(const std::string &socket_path,
+                      const std::string &request, std::string &response)
+{
+    sockaddr_un address;
+    if (!getSocketAddress(socket_path, address))
+        return false;
+
+    const int fd = createSocket();
+    if (fd < 0)
+        return false;
+
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                  sizeof(address))
+            < 0
+        || !writeAll(fd, request + "\n"))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    response = readAll(fd);
+    ::close(fd);
+    return true;
+}
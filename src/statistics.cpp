@@ -0,0 +1,92 @@
+#include "chimera/statistics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+void chimera::Statistics::Add(const std::string &name, std::size_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Find(name) += value;
+}
+
+void chimera::Statistics::Set(const std::string &name, std::size_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Find(name) = value;
+}
+
+std::size_t chimera::Statistics::Get(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &counter : counters_)
+        if (counter.first == name)
+            return counter.second;
+    return 0;
+}
+
+void chimera::Statistics::Print(std::ostream &os) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::size_t width = 0;
+    for (const auto &counter : counters_)
+        width = std::max(width, counter.first.size());
+
+    os << "Chimera statistics:\n";
+    for (const auto &counter : counters_)
+    {
+        os << "  " << counter.first << ": "
+           << std::string(width - counter.first.size(), ' ') << counter.second
+           << "\n";
+    }
+}
+
+std::size_t &chimera::Statistics::Find(const std::string &name)
+{
+    for (auto &counter : counters_)
+        if (counter.first == name)
+            return counter.second;
+
+    counters_.emplace_back(name, 0);
+    return counters_.back().second;
+}
+
+std::size_t chimera::getResidentMemory()
+{
+    // The second field of statm is the resident set size in pages.
+    std::ifstream statm("/proc/self/statm");
+    std::size_t total_pages = 0;
+    std::size_t resident_pages = 0;
+    if (!(statm >> total_pages >> resident_pages))
+        return 0;
+
+    return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+}
+
+std::size_t chimera::getPeakResidentMemory()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+#ifdef __APPLE__
+    // macOS reports the peak resident set size in bytes.
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    // Linux reports the peak resident set size in kilobytes.
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void chimera::releaseFreeMemory()
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+}
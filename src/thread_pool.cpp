@@ -0,0 +1,151 @@
+#include "chimera/thread_pool.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Orders tasks so that a heap has the largest task on top, and among tasks
+// of the same cost the one that was added first.
+struct RunsLater
+{
+    template <typename Task>
+    bool operator()(const Task &lhs, const Task &rhs) const
+    {
+        if (lhs.cost != rhs.cost)
+            return lhs.cost < rhs.cost;
+        return lhs.index > rhs.index;
+    }
+};
+
+} // namespace
+
+chimera::ThreadPool::ThreadPool(unsigned num_threads, std::size_t max_pending)
+  : num_threads_(std::max(num_threads, 1u))
+  , max_pending_(max_pending > 0 ? max_pending : 4 * num_threads_)
+  , num_added_(0)
+  , num_running_(0)
+  , error_index_(0)
+  , stopping_(false)
+{
+    // Do nothing.
+}
+
+chimera::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        pending_.clear();
+    }
+    task_added_.notify_all();
+    for (std::thread &thread : threads_)
+        thread.join();
+}
+
+void chimera::ThreadPool::Add(std::size_t cost, std::function<void()> task)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // The threads start with the first task.
+    if (threads_.empty() && num_threads_ > 1)
+    {
+        for (unsigned i = 0; i < num_threads_; ++i)
+            threads_.emplace_back(&ThreadPool::Work, this);
+    }
+
+    while (!error_ && pending_.size() >= max_pending_)
+    {
+        if (threads_.empty())
+        {
+            Task next = TakeTask();
+            RunTask(next, lock);
+        }
+        else
+            progress_.wait(lock);
+    }
+
+    // After a failure, the tasks are skipped until the failure is reported.
+    if (error_)
+        return;
+
+    pending_.push_back(Task{cost, num_added_++, std::move(task)});
+    std::push_heap(pending_.begin(), pending_.end(), RunsLater());
+    task_added_.notify_one();
+}
+
+void chimera::ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (threads_.empty())
+    {
+        while (!pending_.empty())
+        {
+            Task next = TakeTask();
+            RunTask(next, lock);
+        }
+    }
+    progress_.wait(
+        lock, [this]() { return pending_.empty() && num_running_ == 0; });
+
+    std::exception_ptr error;
+    error.swap(error_);
+    if (error)
+        std::rethrow_exception(error);
+}
+
+unsigned chimera::ThreadPool::GetNumThreads() const
+{
+    return num_threads_;
+}
+
+chimera::ThreadPool::Task chimera::ThreadPool::TakeTask()
+{
+    std::pop_heap(pending_.begin(), pending_.end(), RunsLater());
+    Task task = std::move(pending_.back());
+    pending_.pop_back();
+    ++num_running_;
+    return task;
+}
+
+void chimera::ThreadPool::RunTask(Task &task,
+                                  std::unique_lock<std::mutex> &lock)
+{
+    lock.unlock();
+    std::exception_ptr error;
+    try
+    {
+        task.run();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    lock.lock();
+
+    --num_running_;
+    if (error && (!error_ || task.index < error_index_))
+    {
+        error_ = error;
+        error_index_ = task.index;
+    }
+    if (error_)
+        pending_.clear();
+    progress_.notify_all();
+}
+
+void chimera::ThreadPool::Work()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        task_added_.wait(
+            lock, [this]() { return stopping_ || !pending_.empty(); });
+        if (stopping_)
+            return;
+
+        Task task = TakeTask();
+        progress_.notify_all();
+        RunTask(task, lock);
+    }
+}
@@ -1,14 +1,25 @@
 #include "chimera/util.h"
+#include "chimera/output_writer.h"
 #include "cling_utils_AST.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 #include <clang/AST/ASTConsumer.h>
 #include <clang/AST/Mangle.h>
 #include <clang/Parse/Parser.h>
 #include <clang/Sema/Sema.h>
 #include <clang/Sema/SemaDiagnostic.h>
 #include "clang/AST/DeclTemplate.h"
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 
 namespace chimera
 {
@@ -19,6 +30,10 @@ using namespace clang;
 
 namespace
 {
+
+constexpr int MAX_PATH_LENGTH = 255;
+constexpr int HASH_LENGTH = 16;
+
 /**
  * Empty QualType used when returning a type-resolution failure.
  */
@@ -32,16 +47,84 @@ static const QualType emptyType_;
  */
 std::string generateUniqueName()
 {
-    // Use a static variable to generate non-duplicate names.
-    static unsigned counter = 0;
+    // Use a static variable to generate non-duplicate names, which may be
+    // shared by several runs in the same process.
+    static std::atomic<unsigned> counter(0);
 
     std::stringstream ss;
     ss << "chimera_placeholder_" << (counter++);
     return ss.str();
 }
 
+/**
+ * Memoized results of the type predicates for a single AST context.
+ *
+ * Types are keyed by their canonical type pointer and records by their
+ * declaration, so a type that appears in thousands of method signatures is
+ * only checked (and possibly instantiated by Sema) once.
+ */
+struct TypePredicateCache
+{
+    using TypeTable = std::unordered_map<const void *, bool>;
+    using RecordTable = std::unordered_map<const CXXRecordDecl *, bool>;
+
+    TypeTable incomplete_types;
+    TypeTable copyable_types;
+    TypeTable assignable_types;
+    RecordTable copyable_records;
+    RecordTable assignable_records;
+    TypeCacheStatistics statistics;
+};
+
+std::mutex type_predicate_caches_mutex;
+std::map<const ASTContext *, TypePredicateCache> type_predicate_caches;
+
+/**
+ * Returns the cached result of a predicate, evaluating it on a cache miss.
+ *
+ * The predicate is evaluated without holding the cache lock, since it may
+ * recursively query the cache itself (e.g. for pointee types).
+ */
+template <typename Table, typename Predicate>
+bool memoize(const ASTContext &context, Table TypePredicateCache::*table,
+             const typename Table::key_type &key, Predicate predicate)
+{
+    {
+        std::lock_guard<std::mutex> lock(type_predicate_caches_mutex);
+        TypePredicateCache &cache = type_predicate_caches[&context];
+        const auto it = (cache.*table).find(key);
+        if (it != (cache.*table).end())
+        {
+            ++cache.statistics.hits;
+            return it->second;
+        }
+        ++cache.statistics.misses;
+    }
+
+    const bool result = predicate();
+
+    std::lock_guard<std::mutex> lock(type_predicate_caches_mutex);
+    (type_predicate_caches[&context].*table)[key] = result;
+    return result;
+}
+
 } // namespace
 
+TypeCacheStatistics getTypeCacheStatistics(const ASTContext &context)
+{
+    std::lock_guard<std::mutex> lock(type_predicate_caches_mutex);
+    const auto it = type_predicate_caches.find(&context);
+    if (it == type_predicate_caches.end())
+        return TypeCacheStatistics{};
+    return it->second.statistics;
+}
+
+void clearTypeCaches(const ASTContext &context)
+{
+    std::lock_guard<std::mutex> lock(type_predicate_caches_mutex);
+    type_predicate_caches.erase(&context);
+}
+
 ::mstch::node wrapYAMLNode(const YAML::Node &node, ScalarConversionFn fn)
 {
     switch (node.Type())
@@ -505,53 +588,71 @@ std::string getFullyQualifiedDeclTypeAsString(const TypeDecl *decl)
 
 bool isAssignable(const CXXRecordDecl *decl)
 {
-    if (decl->isAbstract())
-        return false;
-    else if (!decl->hasCopyAssignmentWithConstParam())
-        return false;
+    return memoize(
+        decl->getASTContext(), &TypePredicateCache::assignable_records, decl,
+        [decl]() -> bool {
+            if (decl->isAbstract())
+                return false;
+            else if (!decl->hasCopyAssignmentWithConstParam())
+                return false;
+
+            for (CXXMethodDecl *method_decl : decl->methods())
+                if (method_decl->isCopyAssignmentOperator()
+                    && !method_decl->isDeleted())
+                    return true;
 
-    for (CXXMethodDecl *method_decl : decl->methods())
-        if (method_decl->isCopyAssignmentOperator()
-            && !method_decl->isDeleted())
-            return true;
-
-    return false;
+            return false;
+        });
 }
 
 bool isAssignable(ASTContext &context, QualType qual_type)
 {
-    if (qual_type.isConstQualified())
-        return false;
-    else if (CXXRecordDecl *decl = qual_type.getTypePtr()->getAsCXXRecordDecl())
-        return isAssignable(decl);
-    else if (qual_type.getTypePtr()->isArrayType())
-        return false;
-    else
-        return qual_type.isTriviallyCopyableType(context);
+    return memoize(
+        context, &TypePredicateCache::assignable_types,
+        qual_type.getCanonicalType().getAsOpaquePtr(), [&]() -> bool {
+            if (qual_type.isConstQualified())
+                return false;
+            else if (CXXRecordDecl *decl
+                     = qual_type.getTypePtr()->getAsCXXRecordDecl())
+                return isAssignable(decl);
+            else if (qual_type.getTypePtr()->isArrayType())
+                return false;
+            else
+                return qual_type.isTriviallyCopyableType(context);
+        });
 }
 
 bool isCopyable(const CXXRecordDecl *decl)
 {
-    if (decl->isAbstract())
-        return false;
-    else if (!decl->hasCopyConstructorWithConstParam())
-        return false;
+    return memoize(
+        decl->getASTContext(), &TypePredicateCache::copyable_records, decl,
+        [decl]() -> bool {
+            if (decl->isAbstract())
+                return false;
+            else if (!decl->hasCopyConstructorWithConstParam())
+                return false;
+
+            for (CXXConstructorDecl *ctor_decl : decl->ctors())
+                if (ctor_decl->isCopyConstructor() && !ctor_decl->isDeleted())
+                    return true;
 
-    for (CXXConstructorDecl *ctor_decl : decl->ctors())
-        if (ctor_decl->isCopyConstructor() && !ctor_decl->isDeleted())
-            return true;
-
-    return false;
+            return false;
+        });
 }
 
 bool isCopyable(ASTContext &context, QualType qual_type)
 {
     // TODO: Is this logic correct?
 
-    if (CXXRecordDecl *decl = qual_type.getTypePtr()->getAsCXXRecordDecl())
-        return isCopyable(decl);
-    else
-        return qual_type.isTriviallyCopyableType(context);
+    return memoize(
+        context, &TypePredicateCache::copyable_types,
+        qual_type.getCanonicalType().getAsOpaquePtr(), [&]() -> bool {
+            if (CXXRecordDecl *decl
+                = qual_type.getTypePtr()->getAsCXXRecordDecl())
+                return isCopyable(decl);
+            else
+                return qual_type.isTriviallyCopyableType(context);
+        });
 }
 
 bool isInsideTemplateClass(const DeclContext *decl_context)
@@ -776,32 +877,43 @@ std::set<const CXXRecordDecl *> getBaseClassDecls(
 
 bool containsIncompleteType(Sema &sema, QualType qual_type)
 {
-    const Type *type = qual_type.getTypePtr();
+    // The check is performed on the canonical type, so that sugared
+    // spellings of the same type (e.g. typedefs) share one cache entry.
+    const QualType canonical_type = qual_type.getCanonicalType();
 
-    // TODO: We're probably missing a few cases here.
+    return memoize(
+        sema.getASTContext(), &TypePredicateCache::incomplete_types,
+        canonical_type.getAsOpaquePtr(), [&]() -> bool {
+            const Type *type = canonical_type.getTypePtr();
 
-    if (isa<PointerType>(type))
-    {
-        const PointerType *pointer_type = cast<PointerType>(type);
-        return containsIncompleteType(sema, pointer_type->getPointeeType());
-    }
-    else if (isa<ReferenceType>(type))
-    {
-        const ReferenceType *reference_type = cast<ReferenceType>(type);
-        return containsIncompleteType(sema, reference_type->getPointeeType());
-    }
-    else if (type->isVoidPointerType())
-    {
-        return false;
-    }
-    else if (type->isVoidType())
-    {
-        return false;
-    }
-    else
-    {
-        return sema.RequireCompleteType({}, qual_type, 0);
-    }
+            // TODO: We're probably missing a few cases here.
+
+            if (isa<PointerType>(type))
+            {
+                const PointerType *pointer_type = cast<PointerType>(type);
+                return containsIncompleteType(sema,
+                                              pointer_type->getPointeeType());
+            }
+            else if (isa<ReferenceType>(type))
+            {
+                const ReferenceType *reference_type
+                    = cast<ReferenceType>(type);
+                return containsIncompleteType(
+                    sema, reference_type->getPointeeType());
+            }
+            else if (type->isVoidPointerType())
+            {
+                return false;
+            }
+            else if (type->isVoidType())
+            {
+                return false;
+            }
+            else
+            {
+                return sema.RequireCompleteType({}, canonical_type, 0);
+            }
+        });
 }
 
 bool containsIncompleteType(Sema &sema, const FunctionDecl *decl)
@@ -1021,6 +1133,150 @@ std::string getBuiltinTypeName(const std::string &type_name)
     }
 }
 
+std::uint64_t stableHash(const std::string &str)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : str)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::vector<std::vector<std::size_t>> partitionByCost(
+    const std::vector<std::size_t> &costs, std::size_t count)
+{
+    // Assign the most expensive items first, each to the partition with the
+    // lowest total cost so far.  Ties are broken by the order of the items,
+    // so the assignment is deterministic.
+    std::vector<std::size_t> order(costs.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&costs](std::size_t lhs, std::size_t rhs) {
+                         return costs[lhs] > costs[rhs];
+                     });
+
+    const std::size_t partition_count
+        = std::min(std::max<std::size_t>(count, 1), costs.size());
+    std::vector<std::size_t> partition_costs(partition_count, 0);
+    std::vector<std::vector<std::size_t>> partitions(partition_count);
+    for (const std::size_t index : order)
+    {
+        // Among partitions of the same cost, the one with the fewest items
+        // is chosen, so that items without cost are spread out as well.
+        std::size_t partition_index = 0;
+        for (std::size_t i = 1; i < partition_count; ++i)
+        {
+            if (partition_costs[i] < partition_costs[partition_index]
+                || (partition_costs[i] == partition_costs[partition_index]
+                    && partitions[i].size()
+                           < partitions[partition_index].size()))
+                partition_index = i;
+        }
+        partition_costs[partition_index] += costs[index];
+        partitions[partition_index].push_back(index);
+    }
+
+    for (std::vector<std::size_t> &partition : partitions)
+        std::sort(partition.begin(), partition.end());
+    return partitions;
+}
+
+std::string sanitizePath(const std::string &path)
+{
+    // If the path length is short, just return it.
+    if (path.size() < MAX_PATH_LENGTH)
+        return path;
+
+    // If the path length is long, compute a safe prefix and append a stable
+    // hash of the filename stem.
+    const size_t separator_index = path.find_last_of("/");
+    const size_t stem_index
+        = (separator_index == std::string::npos) ? 0 : separator_index + 1;
+    size_t suffix_index = path.find_last_of(".");
+    if (suffix_index == std::string::npos || suffix_index < stem_index)
+        suffix_index = path.size();
+    const std::string path_suffix = path.substr(suffix_index);
+    const std::string path_stem
+        = path.substr(stem_index, suffix_index - stem_index);
+
+    const int prefix_size = std::max(
+        0, MAX_PATH_LENGTH - HASH_LENGTH - (int)path_suffix.size() - 2);
+    const std::string path_prefix = path.substr(0, prefix_size);
+
+    // Create the new filename as "prefix_{hash}.suffix"
+    std::stringstream ss;
+    ss << path_prefix << "_";
+    ss << std::hex << std::setfill('0') << std::setw(HASH_LENGTH)
+       << stableHash(path_stem);
+    if (path_suffix.length())
+        ss << path_suffix;
+    return ss.str();
+}
+
+std::string hashFileContent(const std::string &path)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer)
+        return "";
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16)
+       << stableHash((*buffer)->getBuffer().str());
+    return ss.str();
+}
+
+bool writeFileHashes(const std::string &path,
+                     const std::vector<std::string> &files)
+{
+    // Each line holds the content hash and path of a file.
+    std::stringstream ss;
+    for (const std::string &file : files)
+        ss << hashFileContent(file) << " " << file << "\n";
+
+    chimera::OutputWriter writer;
+    return writer.Write(path, ss.str());
+}
+
+bool readFileHashes(const std::string &path, std::vector<std::string> &files)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer)
+        return false;
+
+    llvm::SmallVector<llvm::StringRef, 64> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (const llvm::StringRef line : lines)
+    {
+        const std::pair<llvm::StringRef, llvm::StringRef> entry
+            = line.split(' ');
+        if (entry.second.empty()
+            || hashFileContent(entry.second.str()) != entry.first.str())
+            return false;
+        files.push_back(entry.second.str());
+    }
+    return true;
+}
+
+bool isInputArgument(const std::string &argument,
+                     const clang::tooling::CompileCommand &command)
+{
+    if (argument == command.Filename)
+        return true;
+    if (argument.empty() || argument[0] == '-'
+        || llvm::sys::path::is_absolute(argument))
+        return false;
+
+    llvm::SmallString<256> path(command.Directory);
+    llvm::sys::path::append(path, argument);
+    llvm::sys::path::remove_dots(path, true);
+    llvm::SmallString<256> filename(command.Filename);
+    llvm::sys::path::remove_dots(filename, true);
+    return path == filename;
+}
+
 std::string trimRight(std::string s, const char *t)
 {
     s.erase(s.find_last_not_of(t) + 1);
@@ -72,6 +72,48 @@ CXXRecordDecl *GetEnclosingClassDecl(Decl *decl)
     return nullptr;
 }
 
+/**
+ * Records the declarations that must be registered before a declaration.
+ */
+void addDependencies(chimera::DependencyGraph &graph, Decl *decl)
+{
+    using Dependency = chimera::DependencyGraph::Dependency;
+
+    graph.AddDependency(decl, GetEnclosingClassDecl(decl),
+                        Dependency::Enclosing);
+
+    if (auto *class_decl = dyn_cast<CXXRecordDecl>(decl))
+    {
+        for (const CXXRecordDecl *base_decl :
+             graph.GetBaseClassDecls(class_decl))
+            graph.AddDependency(decl, base_decl, Dependency::Base);
+
+        for (const FieldDecl *field_decl : class_decl->fields())
+            if (field_decl->getAccess() == AS_public)
+                graph.AddTypeDependency(decl, field_decl->getType());
+
+        for (const CXXMethodDecl *method_decl : class_decl->methods())
+        {
+            if (method_decl->getAccess() != AS_public)
+                continue;
+
+            graph.AddTypeDependency(decl, method_decl->getReturnType());
+            for (const ParmVarDecl *param_decl : method_decl->parameters())
+                graph.AddTypeDependency(decl, param_decl->getType());
+        }
+    }
+    else if (auto *function_decl = dyn_cast<FunctionDecl>(decl))
+    {
+        graph.AddTypeDependency(decl, function_decl->getReturnType());
+        for (const ParmVarDecl *param_decl : function_decl->parameters())
+            graph.AddTypeDependency(decl, param_decl->getType());
+    }
+    else if (auto *var_decl = dyn_cast<VarDecl>(decl))
+    {
+        graph.AddTypeDependency(decl, var_decl->getType());
+    }
+}
+
 } // namespace
 
 chimera::Visitor::Visitor(clang::CompilerInstance *ci,
@@ -209,8 +251,8 @@ bool chimera::Visitor::GenerateCXXRecord(CXXRecordDecl *decl)
         return false;
 
     // Ensure traversal of base classes before this class.
-    std::set<const CXXRecordDecl *> base_decls
-        = chimera::util::getBaseClassDecls(decl);
+    const std::set<const CXXRecordDecl *> &base_decls
+        = config_.GetDependencyGraph().GetBaseClassDecls(decl);
     for (auto base_decl : base_decls)
     {
         if (traversed_class_decls_.find(base_decl->getCanonicalDecl())
@@ -219,8 +261,8 @@ bool chimera::Visitor::GenerateCXXRecord(CXXRecordDecl *decl)
     }
 
     // Serialize using a mstch template.
-    auto context = std::make_shared<chimera::mstch::CXXRecord>(
-        config_, decl, &traversed_class_decls_);
+    auto context = config_.MakeWrapper<chimera::mstch::CXXRecord>(
+        decl, &traversed_class_decls_);
 
     // TODO(#148): Workaround to skip generating class binding that is
     // unintentionally generated for lambda function in header. See #148 for the
@@ -228,6 +270,7 @@ bool chimera::Visitor::GenerateCXXRecord(CXXRecordDecl *decl)
     if (context->typeAsString() == "(lambda)")
         return false;
 
+    addDependencies(config_.GetDependencyGraph(), decl);
     return config_.Render(context);
 }
 
@@ -238,7 +281,7 @@ bool chimera::Visitor::GenerateEnum(clang::EnumDecl *decl)
         return false;
 
     // Serialize using a mstch template.
-    auto context = std::make_shared<chimera::mstch::Enum>(config_, decl);
+    auto context = config_.MakeWrapper<chimera::mstch::Enum>(decl);
 
     // TODO(#121): Workaround to ignore anonymous enum. The type string of an
     // anonymous enum contains "(anonymous)". See #121 for the details.
@@ -246,6 +289,7 @@ bool chimera::Visitor::GenerateEnum(clang::EnumDecl *decl)
     if (type.find("(anonymous)") != std::string::npos)
         return false;
 
+    addDependencies(config_.GetDependencyGraph(), decl);
     return config_.Render(context);
 }
 
@@ -268,7 +312,8 @@ bool chimera::Visitor::GenerateGlobalVar(clang::VarDecl *decl)
         return false;
 
     // Serialize using a mstch template.
-    auto context = std::make_shared<chimera::mstch::Variable>(config_, decl);
+    auto context = config_.MakeWrapper<chimera::mstch::Variable>(decl);
+    addDependencies(config_.GetDependencyGraph(), decl);
     return config_.Render(context);
 }
 
@@ -312,7 +357,8 @@ bool chimera::Visitor::GenerateGlobalFunction(clang::FunctionDecl *decl)
         return false;
 
     // Serialize using a mstch template.
-    auto context = std::make_shared<chimera::mstch::Function>(config_, decl);
+    auto context = config_.MakeWrapper<chimera::mstch::Function>(decl);
+    addDependencies(config_.GetDependencyGraph(), decl);
     return config_.Render(context);
 }
 
@@ -351,8 +397,9 @@ bool chimera::Visitor::GenerateTypedefName(TypedefNameDecl *decl)
         if (underlying_type_name != "double" && underlying_type_name != "float")
             return false;
 
-        auto context = std::make_shared<chimera::mstch::BuiltinTypedef>(
-            config_, decl, cast<BuiltinType>(underlying_type));
+        auto context = config_.MakeWrapper<chimera::mstch::BuiltinTypedef>(
+            decl, cast<BuiltinType>(underlying_type));
+        addDependencies(config_.GetDependencyGraph(), decl);
         return config_.Render(context);
     }
 
@@ -372,8 +419,12 @@ bool chimera::Visitor::GenerateTypedefName(TypedefNameDecl *decl)
 
     // Create mstch for typedef
     const clang::CXXRecordDecl *underlying_cxx_record_dec = (*it);
-    auto context = std::make_shared<chimera::mstch::Typedef>(
-        config_, decl, underlying_cxx_record_dec);
+    auto context = config_.MakeWrapper<chimera::mstch::Typedef>(
+        decl, underlying_cxx_record_dec);
 
+    addDependencies(config_.GetDependencyGraph(), decl);
+    config_.GetDependencyGraph().AddDependency(
+        decl, underlying_cxx_record_dec,
+        chimera::DependencyGraph::Dependency::Underlying);
     return config_.Render(context);
 }
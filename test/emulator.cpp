@@ -5,6 +5,9 @@
 #include <string>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 
 namespace chimera
 {
@@ -62,6 +65,14 @@ Emulator::Emulator()
 
 //==============================================================================
 void Emulator::Run()
+{
+    Generate();
+
+    exit(0);
+}
+
+//==============================================================================
+int Emulator::Generate()
 {
     std::vector<std::string> args;
     args.push_back("");
@@ -77,6 +88,11 @@ void Emulator::Run()
     if (!modulename_.empty())
         args.push_back("-m=" + modulename_);
 
+    if (!output_path_.empty())
+        args.push_back("-o=" + output_path_);
+
+    args.insert(args.end(), extra_args_.begin(), extra_args_.end());
+
     for (const auto &path : sources_)
     {
         const auto abs_path = GetExamplesDirPath() + path;
@@ -92,9 +108,7 @@ void Emulator::Run()
     }
 
     std::vector<const char *> argv = convertArgs(args);
-    chimera::run(static_cast<int>(argv.size()), argv.data());
-
-    exit(0);
+    return chimera::run(static_cast<int>(argv.size()), argv.data());
 }
 
 //==============================================================================
@@ -181,6 +195,67 @@ void Emulator::SetConfigurationFile(const std::string &path)
     config_filepath_ = GetExamplesDirPath() + path;
 }
 
+//==============================================================================
+void Emulator::SetOutputPath(const std::string &path)
+{
+    output_path_ = path;
+}
+
+//==============================================================================
+void Emulator::AddArgument(const std::string &arg)
+{
+    extra_args_.push_back(arg);
+}
+
+//==============================================================================
+std::string Emulator::MakeOutputDirectory(const std::string &name)
+{
+    const std::string path = GetBuildPath() + "/test_output/" + name;
+    llvm::sys::fs::remove_directories(path);
+    if (std::error_code ec = llvm::sys::fs::create_directories(path))
+    {
+        std::cerr << "Failed to create '" << path << "': " << ec.message()
+                  << std::endl;
+    }
+    return path;
+}
+
+//==============================================================================
+std::map<std::string, std::string> Emulator::ReadDirectory(
+    const std::string &path)
+{
+    std::map<std::string, std::string> files;
+    std::error_code ec;
+    for (llvm::sys::fs::recursive_directory_iterator it(path, ec), end;
+         it != end && !ec; it.increment(ec))
+    {
+        auto buffer = llvm::MemoryBuffer::getFile(it->path());
+        if (!buffer)
+            continue; // Not a regular file.
+
+        const std::string relative_path = it->path().substr(path.size() + 1);
+        files[relative_path] = buffer.get()->getBuffer().str();
+    }
+    return files;
+}
+
+//==============================================================================
+std::map<std::string, std::string> Emulator::GenerateClassExample(
+    const std::string &output_path, const std::vector<std::string> &args)
+{
+    Emulator e;
+    e.SetSource("02_class/class.h");
+    e.SetConfigurationFile("02_class/class.yaml");
+    e.SetBinding("pybind11");
+    e.SetOutputPath(output_path);
+    for (const std::string &arg : args)
+        e.AddArgument(arg);
+
+    if (e.Generate() != 0)
+        return {};
+    return ReadDirectory(output_path);
+}
+
 //==============================================================================
 const std::string &Emulator::GetExamplesDirPath()
 {
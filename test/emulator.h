@@ -1,6 +1,7 @@
 #ifndef __CHIMERA_TEST_EMULATOR_H__
 #define __CHIMERA_TEST_EMULATOR_H__
 
+#include <map>
 #include <string>
 #include <vector>
 #include "chimera/chimera.h"
@@ -17,6 +18,10 @@ public:
 
     void Run();
 
+    /// Runs chimera in-process with the current settings and returns its
+    /// result, so that it can be run several times in the same process.
+    int Generate();
+
     static void Run(const std::string &args);
 
     static void RunHelp();
@@ -32,6 +37,28 @@ public:
 
     void SetConfigurationFile(const std::string &path);
 
+    /// Sets the output bindings directory for option '-o'.
+    void SetOutputPath(const std::string &path);
+
+    /// Adds an extra command-line argument, e.g. "-j=4".
+    void AddArgument(const std::string &arg);
+
+    /// Returns an empty directory under the build path that is named after
+    /// the given test, removing whatever an earlier run left in it.
+    static std::string MakeOutputDirectory(const std::string &name);
+
+    /// Returns the contents of every file under the given directory, keyed
+    /// by their path relative to it.
+    static std::map<std::string, std::string> ReadDirectory(
+        const std::string &path);
+
+    /// Generates the pybind11 bindings of the 02_class example into the
+    /// given directory with extra command-line arguments, and returns the
+    /// files in the directory afterwards, or no files if the run failed.
+    static std::map<std::string, std::string> GenerateClassExample(
+        const std::string &output_path,
+        const std::vector<std::string> &args = {});
+
     static const std::string &GetExamplesDirPath();
     static const std::string &GetBuildPath();
 
@@ -45,6 +72,12 @@ private:
     /// Output top-level module name for option '-m'
     std::string modulename_;
 
+    /// Output bindings directory for option '-o'
+    std::string output_path_;
+
+    /// Extra command-line arguments
+    std::vector<std::string> extra_args_;
+
     /// Sources paths
     std::vector<std::string> sources_;
 };
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+
+namespace chimera_test
+{
+
+// The classes of this hierarchy are spread over several namespaces, so that
+// the bindings of a base and a derived class land in different directories
+// of the hash and namespace output layouts.
+
+namespace animals
+{
+
+class Animal
+{
+public:
+    virtual ~Animal()
+    {
+    }
+    virtual std::string type() const
+    {
+        return "Animal";
+    }
+};
+
+} // namespace animals
+
+namespace pets
+{
+
+class Dog : public animals::Animal
+{
+public:
+    std::string type() const override
+    {
+        return "Dog";
+    }
+};
+
+class Cat : public animals::Animal
+{
+public:
+    std::string type() const override
+    {
+        return "Cat";
+    }
+};
+
+namespace breeds
+{
+
+class Husky : public Dog
+{
+public:
+    std::string type() const override
+    {
+        return "Husky";
+    }
+};
+
+class Siamese : public Cat
+{
+public:
+    std::string type() const override
+    {
+        return "Siamese";
+    }
+};
+
+} // namespace breeds
+
+} // namespace pets
+
+} // namespace chimera_test
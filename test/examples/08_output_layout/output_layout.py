@@ -0,0 +1,34 @@
+import unittest
+
+try:
+    import output_layout_hash_pybind11 as hash_layout
+    import output_layout_namespace_pybind11 as namespace_layout
+    has_pybind11 = True
+except:
+    has_pybind11 = False
+
+
+class TestOutputLayout(unittest.TestCase):
+
+    def check_hierarchy(self, module):
+        self.assertEqual(module.animals.Animal().type(), 'Animal')
+        self.assertEqual(module.pets.Dog().type(), 'Dog')
+        self.assertEqual(module.pets.Cat().type(), 'Cat')
+        self.assertEqual(module.pets.breeds.Husky().type(), 'Husky')
+        self.assertEqual(module.pets.breeds.Siamese().type(), 'Siamese')
+        self.assertTrue(issubclass(module.pets.breeds.Husky,
+                                   module.animals.Animal))
+
+    def test_hash_layout_py11(self):
+        if not has_pybind11:
+            return
+        self.check_hierarchy(hash_layout)
+
+    def test_namespace_layout_py11(self):
+        if not has_pybind11:
+            return
+        self.check_hierarchy(namespace_layout)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,59 @@
+#pragma once
+
+namespace chimera_test
+{
+
+// A class with more method overloads than the split threshold of the test,
+// whose bindings are spread over several part files.
+class Counter
+{
+public:
+    Counter() : value_(0)
+    {
+    }
+
+    int value() const
+    {
+        return value_;
+    }
+
+    void add(int amount)
+    {
+        value_ += amount;
+    }
+
+    void add(int amount, int times)
+    {
+        value_ += amount * times;
+    }
+
+    void subtract(int amount)
+    {
+        value_ -= amount;
+    }
+
+    void reset()
+    {
+        value_ = 0;
+    }
+
+    void set(int value)
+    {
+        value_ = value;
+    }
+
+    int twice() const
+    {
+        return 2 * value_;
+    }
+
+    static int zero()
+    {
+        return 0;
+    }
+
+private:
+    int value_;
+};
+
+} // namespace chimera_test
@@ -0,0 +1,35 @@
+import unittest
+
+try:
+    import split_class_pybind11 as m
+    has_pybind11 = True
+except:
+    has_pybind11 = False
+
+
+class TestSplitClass(unittest.TestCase):
+
+    def test_split_class_py11(self):
+        if not has_pybind11:
+            return
+
+        # Every method is registered on the same class, whichever part file
+        # it was bound in, so they all act on the same instance.
+        counter = m.Counter()
+        counter.add(2)
+        counter.add(3, 2)
+        counter.subtract(1)
+        self.assertEqual(counter.value(), 7)
+        self.assertEqual(counter.twice(), 14)
+        counter.set(5)
+        self.assertEqual(counter.value(), 5)
+        counter.reset()
+        self.assertEqual(counter.value(), 0)
+        self.assertEqual(m.Counter.zero(), 0)
+
+        for name in ['value', 'add', 'subtract', 'reset', 'set', 'twice']:
+            self.assertIn(name, m.Counter.__dict__)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -6,6 +6,8 @@
 #   [DESTINATION destination_dir] # Defaults to `target`
 #   [MODULE module]  # Defaults to `target`
 #   [CONFIGURATION config_file]
+#   [OUTPUT_LAYOUT layout]
+#   [SPLIT_CLASS_THRESHOLD count]
 #   [NAMESPACES namespace1 namespace2 ...])
 #   [DEBUG]
 #   [EXCLUDE_FROM_ALL]
@@ -27,7 +29,7 @@ function(chimera_add_binding_test_pybind11 test_name)
   # Unparsed arguments can be found in variable ARG_UNPARSED_ARGUMENTS.
   set(prefix chimera_test)
   set(options DEBUG EXCLUDE_FROM_ALL COPY_MODULE)
-  set(oneValueArgs TARGET MODULE CONFIGURATION DESTINATION)
+  set(oneValueArgs TARGET MODULE CONFIGURATION DESTINATION OUTPUT_LAYOUT SPLIT_CLASS_THRESHOLD)
   set(multiValueArgs SOURCES NAMESPACES EXTRA_SOURCES INCLUDE_DIRS LINK_LIBRARIES)
   cmake_parse_arguments(
     "${prefix}" "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN}
@@ -49,6 +51,14 @@ function(chimera_add_binding_test_pybind11 test_name)
     set(chimera_binding_CONFIGURATION CONFIGURATION ${chimera_test_CONFIGURATION})
   endif()
 
+  if(chimera_test_OUTPUT_LAYOUT)
+    set(chimera_binding_OUTPUT_LAYOUT OUTPUT_LAYOUT ${chimera_test_OUTPUT_LAYOUT})
+  endif()
+
+  if(chimera_test_SPLIT_CLASS_THRESHOLD)
+    set(chimera_binding_SPLIT_CLASS_THRESHOLD SPLIT_CLASS_THRESHOLD ${chimera_test_SPLIT_CLASS_THRESHOLD})
+  endif()
+
   if(chimera_test_NAMESPACES)
     set(chimera_binding_NAMESPACES NAMESPACES ${chimera_test_NAMESPACES})
   endif()
@@ -69,6 +79,8 @@ function(chimera_add_binding_test_pybind11 test_name)
     ${chimera_binding_DESTINATION}
     ${chimera_binding_MODULE}
     ${chimera_binding_CONFIGURATION}
+    ${chimera_binding_OUTPUT_LAYOUT}
+    ${chimera_binding_SPLIT_CLASS_THRESHOLD}
     ${chimera_binding_NAMESPACES}
     ${chimera_binding_DEBUG}
     ${chimera_binding_EXCLUDE_FROM_ALL}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "chimera/configuration.h"
+
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include "emulator.h"
+
+using namespace chimera;
+using namespace chimera::test;
+
+namespace
+{
+
+/**
+ * Writes a file with the given content.
+ */
+void writeFile(const std::string &path, const std::string &content)
+{
+    std::ofstream file(path);
+    file << content;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(Configuration, MergeShardsListsOutputsInUnshardedOrder)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("ConfigurationMergeShards");
+
+    // The bindings of the previous run included 'stale.cpp'.
+    writeFile(path + "/module.manifest", "a.cpp\nmodule.cpp\nstale.cpp\n");
+    writeFile(path + "/stale.cpp", "// stale.cpp");
+
+    // Each shard lists its outputs with their position in an unsharded run.
+    for (const std::string name : {"module.cpp", "a.cpp", "b.cpp", "c.cpp"})
+        writeFile(path + "/" + name, "// " + name);
+    writeFile(path + "/module.shard-0-of-2",
+              "out 0 module.cpp\nout 2 b.cpp\n"
+              "file module.cpp\nfile b.cpp\n");
+    writeFile(path + "/module.shard-1-of-2",
+              "out 1 a.cpp\nout 3 c.cpp\n"
+              "file a.cpp\nfile c.cpp\n");
+
+    Configuration config;
+    config.SetOutputPath(path);
+    config.SetOutputModuleName("module");
+
+    testing::internal::CaptureStdout();
+    config.MergeShards(2);
+    EXPECT_EQ("module.cpp\na.cpp\nb.cpp\nc.cpp\n",
+              testing::internal::GetCapturedStdout());
+
+    // Only the file that no shard wrote is removed.
+    config.RemoveStaleOutputs();
+    const auto files = Emulator::ReadDirectory(path);
+    EXPECT_EQ(0u, files.count("stale.cpp"));
+    for (const std::string name : {"module.cpp", "a.cpp", "b.cpp", "c.cpp"})
+        EXPECT_EQ("// " + name, files.at(name));
+    EXPECT_EQ("a.cpp\nb.cpp\nc.cpp\nmodule.cpp\n",
+              files.at("module.manifest"));
+}
+
+//==============================================================================
+TEST(Configuration, MergeShardsRequiresEveryListing)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("ConfigurationMergeShardsMissing");
+    writeFile(path + "/module.shard-0-of-2", "out 0 module.cpp\n");
+
+    Configuration config;
+    config.SetOutputPath(path);
+    config.SetOutputModuleName("module");
+    EXPECT_THROW(config.MergeShards(2), std::runtime_error);
+}
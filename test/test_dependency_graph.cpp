@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "chimera/dependency_graph.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <clang/AST/ASTContext.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/Tooling.h>
+
+using namespace chimera;
+
+using Dependency = DependencyGraph::Dependency;
+
+namespace
+{
+
+/**
+ * Parses a source and looks up its top-level records by name.
+ */
+class Source
+{
+public:
+    explicit Source(const std::string &code)
+      : unit_(clang::tooling::buildASTFromCode(code))
+    {
+        // Do nothing.
+    }
+
+    const clang::CXXRecordDecl *GetRecord(const std::string &name) const
+    {
+        for (const clang::Decl *decl : unit_->getASTContext()
+                                           .getTranslationUnitDecl()
+                                           ->decls())
+        {
+            const auto *record_decl
+                = llvm::dyn_cast<clang::CXXRecordDecl>(decl);
+            if (record_decl && record_decl->getName() == name)
+                return record_decl;
+        }
+        ADD_FAILURE() << "No record named '" << name << "'.";
+        return nullptr;
+    }
+
+private:
+    std::unique_ptr<clang::ASTUnit> unit_;
+};
+
+} // namespace
+
+//==============================================================================
+TEST(DependencyGraph, BasesPrecedeDerivedClasses)
+{
+    const Source source("struct Base {};\n"
+                        "struct Middle : Base {};\n"
+                        "struct Derived : Middle {};\n"
+                        "struct Other {};\n");
+
+    // The bindings are added in the reverse order of their dependencies.
+    DependencyGraph graph;
+    graph.AddBinding(source.GetRecord("Derived"), "Derived");
+    graph.AddBinding(source.GetRecord("Other"), "Other");
+    graph.AddBinding(source.GetRecord("Middle"), "Middle");
+    graph.AddBinding(source.GetRecord("Base"), "Base");
+    graph.AddDependency(source.GetRecord("Derived"), source.GetRecord("Middle"),
+                        Dependency::Base);
+    graph.AddDependency(source.GetRecord("Middle"), source.GetRecord("Base"),
+                        Dependency::Base);
+
+    EXPECT_EQ(4u, graph.GetNumBindings());
+    EXPECT_EQ((std::vector<std::string>{"Other", "Base", "Middle", "Derived"}),
+              graph.GetTopologicalOrder());
+}
+
+//==============================================================================
+TEST(DependencyGraph, IgnoresDependenciesOnUnrenderedDeclarations)
+{
+    const Source source("struct Base {};\n"
+                        "struct Derived : Base {};\n");
+
+    DependencyGraph graph;
+    graph.AddBinding(source.GetRecord("Derived"), "Derived");
+    graph.AddDependency(source.GetRecord("Derived"), source.GetRecord("Base"),
+                        Dependency::Base);
+
+    EXPECT_EQ(std::vector<std::string>{"Derived"},
+              graph.GetTopologicalOrder());
+}
+
+//==============================================================================
+TEST(DependencyGraph, BreaksSoftCycles)
+{
+    const Source source("struct A;\n"
+                        "struct B;\n"
+                        "struct C;\n"
+                        "struct A { B *b; };\n"
+                        "struct B { A *a; C *c; };\n"
+                        "struct C : A {};\n");
+
+    // A and B use each other, and B uses C, which derives from A.  The cycle
+    // is broken at B, the earliest added binding whose hard dependencies are
+    // all satisfied, and C still follows its base class.
+    DependencyGraph graph;
+    graph.AddBinding(source.GetRecord("C"), "C");
+    graph.AddBinding(source.GetRecord("B"), "B");
+    graph.AddBinding(source.GetRecord("A"), "A");
+    graph.AddDependency(source.GetRecord("A"), source.GetRecord("B"),
+                        Dependency::Type);
+    graph.AddDependency(source.GetRecord("B"), source.GetRecord("A"),
+                        Dependency::Type);
+    graph.AddDependency(source.GetRecord("B"), source.GetRecord("C"),
+                        Dependency::Type);
+    graph.AddDependency(source.GetRecord("C"), source.GetRecord("A"),
+                        Dependency::Base);
+
+    // Every binding is still emitted exactly once.
+    const std::vector<std::string> order = graph.GetTopologicalOrder();
+    EXPECT_EQ((std::vector<std::string>{"B", "A", "C"}), order);
+}
+
+//==============================================================================
+TEST(DependencyGraph, WriteDot)
+{
+    const Source source("struct A;\n"
+                        "struct B { A *a; };\n"
+                        "struct A : B {};\n");
+
+    DependencyGraph graph;
+    graph.AddBinding(source.GetRecord("B"), "B");
+    graph.AddBinding(source.GetRecord("A"), "A");
+    graph.AddDependency(source.GetRecord("A"), source.GetRecord("B"),
+                        Dependency::Base);
+    graph.AddDependency(source.GetRecord("B"), source.GetRecord("A"),
+                        Dependency::Type);
+
+    // A weaker kind of dependency does not replace a stronger one.
+    graph.AddDependency(source.GetRecord("A"), source.GetRecord("B"),
+                        Dependency::Type);
+
+    std::stringstream dot;
+    graph.WriteDot(dot);
+    EXPECT_EQ("digraph chimera {\n"
+              "  \"B\";\n"
+              "  \"A\";\n"
+              "  \"B\" -> \"A\" [style=dashed];\n"
+              "  \"A\" -> \"B\";\n"
+              "}\n",
+              dot.str());
+    EXPECT_EQ((std::vector<std::string>{"B", "A"}),
+              graph.GetTopologicalOrder());
+}
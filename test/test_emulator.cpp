@@ -90,3 +90,176 @@ TEST(Emulator, issue228)
     // doesn't stop at the breakpoints. For debugging use e.Run() instead.
     EXPECT_EXIT(e.Run(), ::testing::ExitedWithCode(0), ".*");
 }
+
+//==============================================================================
+TEST(Emulator, RunTwiceInProcess)
+{
+    Emulator e;
+    e.SetSource("01_function/function.h");
+    e.SetConfigurationFile("01_function/function_pybind11.yaml");
+    e.SetBinding("pybind11");
+
+    const std::string output_path
+        = Emulator::MakeOutputDirectory("RunTwiceInProcess");
+    e.SetOutputPath(output_path);
+
+    // Both runs happen in this process, so the second one would see any state
+    // left behind by the first one.
+    EXPECT_EQ(0, e.Generate());
+    const auto first = Emulator::ReadDirectory(output_path);
+    EXPECT_FALSE(first.empty());
+
+    EXPECT_EQ(0, e.Generate());
+    const auto second = Emulator::ReadDirectory(output_path);
+    EXPECT_EQ(first, second);
+}
+
+//==============================================================================
+TEST(Emulator, RenderOnSeveralThreads)
+{
+    // The bindings do not depend on the order in which they were rendered.
+    const auto serial = Emulator::GenerateClassExample(
+        Emulator::MakeOutputDirectory("RenderOnSeveralThreads/1"), {"-j=1"});
+    EXPECT_FALSE(serial.empty());
+    EXPECT_EQ(serial,
+              Emulator::GenerateClassExample(
+                  Emulator::MakeOutputDirectory("RenderOnSeveralThreads/4"),
+                  {"-j=4"}));
+}
+
+//==============================================================================
+TEST(Emulator, WriteOnBackgroundThread)
+{
+    const std::string path = "WriteOnBackgroundThread/";
+    const auto synchronous = Emulator::GenerateClassExample(
+        Emulator::MakeOutputDirectory(path + "synchronous"));
+    EXPECT_FALSE(synchronous.empty());
+    EXPECT_EQ(synchronous,
+              Emulator::GenerateClassExample(
+                  Emulator::MakeOutputDirectory(path + "queued"),
+                  {"-write-queue=2"}));
+}
+
+//==============================================================================
+TEST(Emulator, RenderAfterReleasingAST)
+{
+    // The bindings rendered from the extracted data are the same as the ones
+    // rendered from the AST.
+    const auto live = Emulator::GenerateClassExample(
+        Emulator::MakeOutputDirectory("RenderAfterReleasingAST/live"));
+    EXPECT_FALSE(live.empty());
+    EXPECT_EQ(live,
+              Emulator::GenerateClassExample(
+                  Emulator::MakeOutputDirectory("RenderAfterReleasingAST/1"),
+                  {"-release-ast"}));
+    EXPECT_EQ(live,
+              Emulator::GenerateClassExample(
+                  Emulator::MakeOutputDirectory("RenderAfterReleasingAST/4"),
+                  {"-release-ast", "-j=4"}));
+}
+
+//==============================================================================
+TEST(Emulator, MergeShards)
+{
+    // The merge lists the same sources as an unsharded run, in the same order.
+    testing::internal::CaptureStdout();
+    const auto unsharded = Emulator::GenerateClassExample(
+        Emulator::MakeOutputDirectory("MergeShards/unsharded"));
+    const std::string unsharded_list = testing::internal::GetCapturedStdout();
+    EXPECT_FALSE(unsharded.empty());
+    EXPECT_FALSE(unsharded_list.empty());
+
+    const std::string sharded_path
+        = Emulator::MakeOutputDirectory("MergeShards/sharded");
+    for (const std::string shard : {"0/3", "1/3", "2/3"})
+    {
+        EXPECT_FALSE(
+            Emulator::GenerateClassExample(sharded_path, {"-shard=" + shard})
+                .empty());
+    }
+    testing::internal::CaptureStdout();
+    auto sharded
+        = Emulator::GenerateClassExample(sharded_path, {"-merge-shards=3"});
+    EXPECT_EQ(unsharded_list, testing::internal::GetCapturedStdout());
+
+    // The shards write the same files, apart from their listings.
+    for (auto it = sharded.begin(); it != sharded.end();)
+    {
+        if (it->first.find(".shard-") != std::string::npos)
+            it = sharded.erase(it);
+        else
+            ++it;
+    }
+    EXPECT_EQ(unsharded, sharded);
+}
+
+//==============================================================================
+TEST(Emulator, SplitClass)
+{
+    Emulator e;
+    e.SetSource("09_split_class/split_class.h");
+    e.SetBinding("pybind11");
+    e.AddArgument("-n=chimera_test");
+    e.AddArgument("-split-class-threshold=2");
+
+    const std::string output_path = Emulator::MakeOutputDirectory("SplitClass");
+    e.SetOutputPath(output_path);
+    EXPECT_EQ(0, e.Generate());
+
+    // Counter has seven instance method overloads, so the class source binds
+    // the first two and passes its class object to each of the part files.
+    std::string class_source;
+    std::size_t num_parts = 0;
+    for (const auto &file : Emulator::ReadDirectory(output_path))
+    {
+        if (file.first.find("_part_") != std::string::npos)
+            ++num_parts;
+        else if (file.first.find("Counter.cpp") != std::string::npos)
+            class_source = file.second;
+    }
+    EXPECT_GE(num_parts, 3u);
+    for (std::size_t part = 1; part <= num_parts; ++part)
+    {
+        EXPECT_NE(std::string::npos,
+                  class_source.find("_part_" + std::to_string(part) + "(cl);"))
+            << "Part " << part << " is not registered against the class.";
+    }
+}
+
+//==============================================================================
+TEST(Emulator, MinimalIncludesCoverHeldType)
+{
+    Emulator e;
+    e.SetSource("03_smart_pointers/smart_pointers.h");
+    e.SetConfigurationFile("03_smart_pointers/smart_pointers_pybind11.yaml");
+    e.SetBinding("pybind11");
+    e.AddArgument("-minimal-includes");
+
+    const std::string output_path
+        = Emulator::MakeOutputDirectory("MinimalIncludesCoverHeldType");
+    e.SetOutputPath(output_path);
+    EXPECT_EQ(0, e.Generate());
+
+    // ExampleShared uses no standard types itself, so <memory> is only
+    // included for the std::shared_ptr that holds it.
+    std::string class_source;
+    for (const auto &file : Emulator::ReadDirectory(output_path))
+        if (file.first.find("ExampleShared.cpp") != std::string::npos)
+            class_source = file.second;
+    ASSERT_FALSE(class_source.empty());
+    EXPECT_NE(std::string::npos, class_source.find("#include <memory>"));
+}
+
+//==============================================================================
+TEST(Emulator, InvalidOptionsAreReported)
+{
+    Emulator e;
+    e.SetSource("02_class/class.h");
+    e.SetBinding("pybind11");
+    e.SetOutputPath(Emulator::MakeOutputDirectory("InvalidOptionsAreReported"));
+    e.AddArgument("-shard=3/3");
+
+    testing::internal::CaptureStderr();
+    EXPECT_EQ(1, e.Generate());
+    EXPECT_FALSE(testing::internal::GetCapturedStderr().empty());
+}
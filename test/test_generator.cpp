@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "chimera/generator.h"
+#include "chimera/server.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include "emulator.h"
+
+using namespace chimera;
+using namespace chimera::test;
+
+//==============================================================================
+TEST(Generator, CreateConfigurationsForSeveralModules)
+{
+    clang::tooling::FixedCompilationDatabase compilations(".", {});
+    GeneratorOptions options;
+    options.output_path = "bindings";
+    options.modules = {parseModuleSpec("name=first,output=bindings/first"),
+                       parseModuleSpec("name=second,output=bindings/second")};
+
+    Generator generator(compilations, {}, options);
+    const auto configs = generator.CreateConfigurations();
+    ASSERT_EQ(2u, configs.size());
+    EXPECT_EQ("bindings/first", configs[0]->GetOutputPath());
+    EXPECT_EQ("bindings/second", configs[1]->GetOutputPath());
+}
+
+//==============================================================================
+TEST(Generator, CreateConfigurationsRejectsSharedOutputPath)
+{
+    clang::tooling::FixedCompilationDatabase compilations(".", {});
+    GeneratorOptions options;
+    options.output_path = "bindings";
+
+    // The modules would overwrite and remove each other's binding files, even
+    // though their top-level files have different names.
+    options.modules = {parseModuleSpec("name=first"),
+                       parseModuleSpec("name=second,output=./bindings/")};
+    Generator generator(compilations, {}, options);
+    EXPECT_THROW(generator.CreateConfigurations(), std::invalid_argument);
+
+    // Several bindings of a module are written to subdirectories.
+    options.modules
+        = {parseModuleSpec("binding=pybind11,binding=boost_python")};
+    Generator bindings_generator(compilations, {}, options);
+    EXPECT_EQ(2u, bindings_generator.CreateConfigurations().size());
+}
+
+//==============================================================================
+TEST(Generator, ParseShardSpec)
+{
+    unsigned index = 0;
+    unsigned count = 0;
+    parseShardSpec("2/3", index, count);
+    EXPECT_EQ(2u, index);
+    EXPECT_EQ(3u, count);
+
+    parseShardSpec("0/1", index, count);
+    EXPECT_EQ(0u, index);
+    EXPECT_EQ(1u, count);
+
+    for (const char *spec : {"", "1", "3/3", "4/3", "1/0", "1:3", "1/3/5",
+                             "1/3x", "-1/3", "a/b"})
+    {
+        EXPECT_THROW(parseShardSpec(spec, index, count), std::invalid_argument)
+            << "Shard '" << spec << "' was accepted.";
+    }
+}
+
+//==============================================================================
+TEST(Generator, ServeGeneratesLikeRun)
+{
+    clang::tooling::FixedCompilationDatabase compilations(
+        ".", {"-x", "c++", "-std=c++11"});
+    const std::vector<std::string> sources
+        = {Emulator::GetExamplesDirPath() + "01_function/function.h",
+           Emulator::GetExamplesDirPath() + "02_class/class.h"};
+    GeneratorOptions options;
+    options.binding_names = {"pybind11"};
+    options.module_name = "chimera_test";
+    options.namespace_names = {"chimera_test"};
+
+    // A run generates the bindings of the first source only.
+    options.output_path = Emulator::MakeOutputDirectory("ServeLikeRun/run");
+    Generator generator(compilations, sources, options);
+    EXPECT_EQ(0, generator.Run(generator.CreateConfigurations()));
+    const auto run_files = Emulator::ReadDirectory(options.output_path);
+    EXPECT_FALSE(run_files.empty());
+
+    options.output_path = Emulator::MakeOutputDirectory("ServeLikeRun/serve");
+    const std::string socket_path
+        = "/tmp/chimera_test_" + std::to_string(::getpid()) + "_generator";
+    Generator server_generator(compilations, sources, options);
+    std::thread server(
+        [&]() { server_generator.Serve(socket_path, "key"); });
+
+    std::string response;
+    bool answered = false;
+    for (int attempt = 0; attempt < 500 && !answered; ++attempt)
+    {
+        answered = request(socket_path, "generate key", response);
+        if (!answered)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(answered);
+    EXPECT_EQ(std::string::npos, response.find("error "));
+    EXPECT_TRUE(request(socket_path, "stop", response));
+    server.join();
+
+    EXPECT_EQ(run_files, Emulator::ReadDirectory(options.output_path));
+}
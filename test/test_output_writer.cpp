@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include "chimera/output_writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utime.h>
+#include <vector>
+#include <llvm/Support/FileSystem.h>
+#include "emulator.h"
+
+using namespace chimera;
+using namespace chimera::test;
+
+namespace
+{
+
+/**
+ * Writes a number of files with the given writer and returns their contents.
+ */
+std::map<std::string, std::string> writeFiles(OutputWriter &writer,
+                                              const std::string &directory)
+{
+    for (int i = 0; i < 32; ++i)
+    {
+        const std::string name = "sub" + std::to_string(i % 3) + "/file"
+                                 + std::to_string(i) + ".cpp";
+        EXPECT_TRUE(writer.Write(directory + "/" + name,
+                                 "// file " + std::to_string(i) + "\n"));
+    }
+    writer.Flush();
+    return Emulator::ReadDirectory(directory);
+}
+
+/**
+ * Returns the modification time of a file in seconds since the epoch.
+ */
+long long getModificationTime(const std::string &path)
+{
+    llvm::sys::fs::file_status status;
+    EXPECT_FALSE(llvm::sys::fs::status(path, status));
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               status.getLastModificationTime().time_since_epoch())
+        .count();
+}
+
+/**
+ * Sets the modification time of a file to the given seconds since the epoch.
+ */
+void setModificationTime(const std::string &path, long long seconds)
+{
+    struct utimbuf times;
+    times.actime = static_cast<time_t>(seconds);
+    times.modtime = static_cast<time_t>(seconds);
+    EXPECT_EQ(0, utime(path.c_str(), &times));
+}
+
+} // namespace
+
+//==============================================================================
+TEST(OutputWriter, UnchangedFileKeepsModificationTime)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("OutputWriter/unchanged");
+    {
+        OutputWriter writer;
+        EXPECT_TRUE(writer.Write(path + "/same.h", "// same\n"));
+        EXPECT_TRUE(writer.Write(path + "/changed.h", "// before\n"));
+        EXPECT_EQ(2u, writer.GetNumWritten());
+    }
+
+    // Backdate the files, so that a rewrite would be visible even within the
+    // resolution of the file system's timestamps.
+    setModificationTime(path + "/same.h", 1000000000);
+    setModificationTime(path + "/changed.h", 1000000000);
+
+    OutputWriter writer;
+    EXPECT_TRUE(writer.Write(path + "/same.h", "// same\n"));
+    EXPECT_TRUE(writer.Write(path + "/changed.h", "// after\n"));
+    EXPECT_EQ(1u, writer.GetNumWritten());
+    EXPECT_EQ(1u, writer.GetNumUnchanged());
+    EXPECT_EQ(std::vector<std::string>{path + "/changed.h"},
+              writer.GetChangedPaths());
+
+    EXPECT_EQ(1000000000, getModificationTime(path + "/same.h"));
+    EXPECT_NE(1000000000, getModificationTime(path + "/changed.h"));
+}
+
+//==============================================================================
+TEST(OutputWriter, ManifestRemovesFilesThatAreNoLongerWritten)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("OutputWriter/manifest");
+    const std::string manifest_path = path + "/module.manifest";
+    {
+        OutputWriter writer;
+        for (const std::string name : {"kept.h", "kept.cpp", "sub/gone.h",
+                                       "sub/gone.cpp", "module.cpp"})
+            EXPECT_TRUE(writer.Write(path + "/" + name, "// " + name));
+        EXPECT_TRUE(writer.UpdateManifest(manifest_path).empty());
+    }
+
+    // A file that the writer did not write is never removed.
+    OutputWriter other;
+    EXPECT_TRUE(other.Write(path + "/other.h", "// other.h"));
+
+    // The declaration that was bound by 'gone.h' and 'gone.cpp' was removed.
+    OutputWriter writer;
+    for (const std::string name : {"kept.h", "kept.cpp", "module.cpp"})
+        EXPECT_TRUE(writer.Write(path + "/" + name, "// " + name));
+    std::vector<std::string> removed = writer.UpdateManifest(manifest_path);
+    std::sort(removed.begin(), removed.end());
+    EXPECT_EQ((std::vector<std::string>{path + "/sub/gone.cpp",
+                                        path + "/sub/gone.h"}),
+              removed);
+
+    std::map<std::string, std::string> expected;
+    for (const std::string name : {"kept.h", "kept.cpp", "module.cpp",
+                                   "other.h"})
+        expected[name] = "// " + name;
+    expected["module.manifest"] = "kept.cpp\nkept.h\nmodule.cpp\n";
+    EXPECT_EQ(expected, Emulator::ReadDirectory(path));
+}
+
+//==============================================================================
+TEST(OutputWriter, QueuedOutputEqualsSynchronousOutput)
+{
+    const std::string sync_path
+        = Emulator::MakeOutputDirectory("OutputWriter/synchronous");
+    OutputWriter sync_writer;
+    const auto sync_files = writeFiles(sync_writer, sync_path);
+
+    const std::string queued_path
+        = Emulator::MakeOutputDirectory("OutputWriter/queued");
+    OutputWriter queued_writer;
+    queued_writer.SetQueueSize(2);
+    const auto queued_files = writeFiles(queued_writer, queued_path);
+
+    EXPECT_EQ(32u, sync_files.size());
+    EXPECT_EQ(sync_files, queued_files);
+    EXPECT_EQ(sync_writer.GetNumWritten(), queued_writer.GetNumWritten());
+    EXPECT_EQ(0u, queued_writer.GetNumUnchanged());
+}
+
+//==============================================================================
+TEST(OutputWriter, QueuedFailureIsReportedByFlush)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("OutputWriter/queued_failure");
+
+    // A file cannot be written below a regular file.
+    OutputWriter writer;
+    writer.SetQueueSize(2);
+    EXPECT_TRUE(writer.Write(path + "/file.h", "// file\n"));
+    EXPECT_TRUE(writer.Write(path + "/file.h/nested.h", "// nested\n"));
+    EXPECT_TRUE(writer.Write(path + "/other.h", "// other\n"));
+    EXPECT_THROW(writer.Flush(), std::runtime_error);
+
+    // The files around the failure are still written, and the failure is
+    // only reported once.
+    EXPECT_EQ(2u, writer.GetNumWritten());
+    EXPECT_NO_THROW(writer.Flush());
+}
+
+//==============================================================================
+TEST(OutputWriter, SynchronousFailureIsReturned)
+{
+    const std::string path
+        = Emulator::MakeOutputDirectory("OutputWriter/synchronous_failure");
+
+    OutputWriter writer;
+    EXPECT_TRUE(writer.Write(path + "/file.h", "// file\n"));
+    EXPECT_FALSE(writer.Write(path + "/file.h/nested.h", "// nested\n"));
+    EXPECT_NO_THROW(writer.Flush());
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "chimera/server.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace chimera;
+
+namespace
+{
+
+/**
+ * Returns a socket path that is short enough for a socket address.
+ */
+std::string getSocketPath(const std::string &name)
+{
+    return "/tmp/chimera_test_" + std::to_string(::getpid()) + "_" + name;
+}
+
+/**
+ * Sends a request to a server that may not be listening yet.
+ */
+bool waitForResponse(const std::string &socket_path,
+                     const std::string &request, std::string &response)
+{
+    for (int attempt = 0; attempt < 500; ++attempt)
+    {
+        if (chimera::request(socket_path, request, response))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(Server, AnswersRequests)
+{
+    const std::string path = getSocketPath("answers");
+    std::thread server([&path]() {
+        serve(path, [](const std::string &line) { return line + "!"; });
+    });
+
+    std::string response;
+    EXPECT_TRUE(waitForResponse(path, "hello", response));
+    EXPECT_EQ("hello!", response);
+
+    EXPECT_TRUE(request(path, "stop", response));
+    server.join();
+    EXPECT_FALSE(request(path, "hello", response));
+}
+
+//==============================================================================
+TEST(Server, ReplacesSocketOfStoppedServer)
+{
+    // A server that was killed leaves its socket behind.
+    const std::string path = getSocketPath("stopped");
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(0, ::bind(fd, reinterpret_cast<const sockaddr *>(&address),
+                        sizeof(address)));
+    ::close(fd);
+
+    std::thread server([&path]() {
+        serve(path, [](const std::string &line) { return line; });
+    });
+    std::string response;
+    EXPECT_TRUE(waitForResponse(path, "ping", response));
+    EXPECT_TRUE(request(path, "stop", response));
+    server.join();
+}
+
+//==============================================================================
+TEST(Server, RefusesPathOfAnotherFile)
+{
+    const std::string path = getSocketPath("file");
+    {
+        std::ofstream file(path);
+        file << "content";
+    }
+
+    const auto handler = [](const std::string &line) { return line; };
+    EXPECT_THROW(serve(path, handler), std::runtime_error);
+
+    // The file is left alone.
+    std::ifstream file(path);
+    std::string content;
+    file >> content;
+    EXPECT_EQ("content", content);
+    ::unlink(path.c_str());
+}
+
+//==============================================================================
+TEST(Server, RefusesSocketOfRunningServer)
+{
+    const std::string path = getSocketPath("running");
+    const auto handler = [](const std::string &line) { return line; };
+    std::thread server([&]() { serve(path, handler); });
+
+    std::string response;
+    ASSERT_TRUE(waitForResponse(path, "ping", response));
+    EXPECT_THROW(serve(path, handler), std::runtime_error);
+
+    // The running server still answers.
+    EXPECT_TRUE(request(path, "ping", response));
+    EXPECT_EQ("ping", response);
+    EXPECT_TRUE(request(path, "stop", response));
+    server.join();
+}
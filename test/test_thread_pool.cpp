@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "chimera/thread_pool.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace chimera;
+
+//==============================================================================
+TEST(ThreadPool, RunsEveryTask)
+{
+    ThreadPool pool(4);
+    std::atomic<int> sum(0);
+    for (int i = 1; i <= 100; ++i)
+        pool.Add(i % 7, [&sum, i]() { sum += i; });
+    pool.Wait();
+    EXPECT_EQ(5050, sum);
+
+    // Waiting again without adding tasks does nothing.
+    pool.Wait();
+    EXPECT_EQ(5050, sum);
+}
+
+//==============================================================================
+TEST(ThreadPool, RunsLargestFirst)
+{
+    ThreadPool pool(1);
+    std::vector<int> order;
+    pool.Add(1, [&order]() { order.push_back(0); });
+    pool.Add(3, [&order]() { order.push_back(1); });
+    pool.Add(2, [&order]() { order.push_back(2); });
+    pool.Add(3, [&order]() { order.push_back(3); });
+    pool.Wait();
+    EXPECT_EQ((std::vector<int>{1, 3, 2, 0}), order);
+}
+
+//==============================================================================
+TEST(ThreadPool, BoundsPendingTasks)
+{
+    // Without threads, a full pool runs its largest task to make room.
+    ThreadPool pool(1, 2);
+    std::vector<int> order;
+    pool.Add(1, [&order]() { order.push_back(0); });
+    pool.Add(3, [&order]() { order.push_back(1); });
+    EXPECT_TRUE(order.empty());
+    pool.Add(2, [&order]() { order.push_back(2); });
+    EXPECT_EQ(std::vector<int>{1}, order);
+    pool.Wait();
+    EXPECT_EQ((std::vector<int>{1, 2, 0}), order);
+}
+
+//==============================================================================
+TEST(ThreadPool, RunsTasksWhileTheyAreAdded)
+{
+    ThreadPool pool(2, 1);
+    std::mutex mutex;
+    int finished = 0;
+    for (int i = 0; i < 20; ++i)
+    {
+        pool.Add(1, [&mutex, &finished]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++finished;
+        });
+    }
+
+    // At most one task waits and two run, so the others already finished.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_GE(finished, 17);
+    }
+    pool.Wait();
+    EXPECT_EQ(20, finished);
+}
+
+//==============================================================================
+TEST(ThreadPool, RethrowsEarliestAddedFailure)
+{
+    ThreadPool pool(4);
+    for (int i = 0; i < 8; ++i)
+    {
+        pool.Add(1, [i]() {
+            if (i % 2 == 1)
+                throw std::runtime_error(std::to_string(i));
+        });
+    }
+
+    try
+    {
+        pool.Wait();
+        FAIL() << "Wait did not rethrow the failure of a task.";
+    }
+    catch (const std::runtime_error &e)
+    {
+        EXPECT_STREQ("1", e.what());
+    }
+}
+
+//==============================================================================
+TEST(ThreadPool, SkipsTasksAfterFailure)
+{
+    ThreadPool pool(1);
+    std::vector<int> order;
+    pool.Add(3, [&order]() { order.push_back(0); });
+    pool.Add(2, []() { throw std::runtime_error("failed"); });
+    pool.Add(1, [&order]() { order.push_back(2); });
+    EXPECT_THROW(pool.Wait(), std::runtime_error);
+    EXPECT_EQ(std::vector<int>{0}, order);
+
+    // The failure was reported, so the pool runs new tasks.
+    pool.Add(1, [&order]() { order.push_back(3); });
+    pool.Wait();
+    EXPECT_EQ((std::vector<int>{0, 3}), order);
+}
+
+//==============================================================================
+TEST(ThreadPool, ShutsDownAfterFailureOnEveryThread)
+{
+    ThreadPool pool(4);
+    std::atomic<int> started(0);
+    for (int i = 0; i < 100; ++i)
+    {
+        pool.Add(1, [&started]() {
+            ++started;
+            throw std::runtime_error("failed");
+        });
+    }
+    EXPECT_THROW(pool.Wait(), std::runtime_error);
+
+    // Each thread stops after its first failure.
+    EXPECT_GE(started, 1);
+    EXPECT_LE(started, 4);
+}
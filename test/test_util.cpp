@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "chimera/util.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <clang/AST/ASTContext.h>
+#include <clang/Frontend/ASTUnit.h>
+#include <clang/Tooling/Tooling.h>
+
+using namespace chimera;
+
+//==============================================================================
+TEST(Util, StableHash)
+{
+    // The hash is 64-bit FNV-1a, so names derived from it never change.
+    EXPECT_EQ(0xcbf29ce484222325ull, util::stableHash(""));
+    EXPECT_EQ(0xaf63dc4c8601ec8cull, util::stableHash("a"));
+    EXPECT_EQ(0x469043b0f9dff14aull, util::stableHash("chimera"));
+}
+
+//==============================================================================
+TEST(Util, SanitizePathKeepsShortPaths)
+{
+    EXPECT_EQ("out/class_Foo.h", util::sanitizePath("out/class_Foo.h"));
+
+    const std::string path = "out/" + std::string(240, 'a') + ".h";
+    EXPECT_EQ(path, util::sanitizePath(path));
+}
+
+//==============================================================================
+TEST(Util, SanitizePathShortensLongPaths)
+{
+    const std::string stem = "class_" + std::string(300, 'a');
+
+    // The header and source of a binding share the hash of its full name.
+    EXPECT_EQ("out/class_" + std::string(225, 'a') + "_7310b6ef76f24413.h",
+              util::sanitizePath("out/" + stem + "_Foo.h"));
+    EXPECT_EQ("out/class_" + std::string(223, 'a') + "_7310b6ef76f24413.cpp",
+              util::sanitizePath("out/" + stem + "_Foo.cpp"));
+    EXPECT_EQ("out/class_" + std::string(225, 'a') + "_4ea325ef61cef37e.h",
+              util::sanitizePath("out/" + stem + "_Bar.h"));
+}
+
+//==============================================================================
+TEST(Util, SanitizePathDoesNotDependOnOrder)
+{
+    // Names that only differ past the truncation do not collide, and each
+    // name is the same whichever order the bindings are visited in.
+    const std::string prefix = "out/class_" + std::string(300, 'a') + "_";
+    std::set<std::string> forward;
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string path
+            = util::sanitizePath(prefix + std::to_string(i) + ".h");
+        EXPECT_LT(path.size(), 256u);
+        forward.insert(path);
+    }
+    EXPECT_EQ(100u, forward.size());
+
+    std::set<std::string> backward;
+    for (int i = 99; i >= 0; --i)
+        backward.insert(util::sanitizePath(prefix + std::to_string(i) + ".h"));
+    EXPECT_EQ(forward, backward);
+}
+
+//==============================================================================
+TEST(Util, TypePredicatesAreCachedPerType)
+{
+    const std::unique_ptr<clang::ASTUnit> unit
+        = clang::tooling::buildASTFromCode("struct Vector {\n"
+                                           "  Vector(const Vector &);\n"
+                                           "  double x;\n"
+                                           "};\n"
+                                           "void f(Vector a, Vector b);\n"
+                                           "void g(Vector a, double b);\n"
+                                           "void h(double a, double b);\n");
+    ASSERT_TRUE(unit != nullptr);
+    clang::ASTContext &context = unit->getASTContext();
+
+    std::vector<const clang::FunctionDecl *> function_decls;
+    for (const clang::Decl *decl : context.getTranslationUnitDecl()->decls())
+        if (auto *function_decl = llvm::dyn_cast<clang::FunctionDecl>(decl))
+            function_decls.push_back(function_decl);
+    ASSERT_EQ(3u, function_decls.size());
+
+    // 'Vector' is checked as a type and as a record the first time, and
+    // 'double' as a type; every other parameter is answered by the cache.
+    for (const clang::FunctionDecl *function_decl : function_decls)
+        EXPECT_FALSE(util::containsNonCopyableType(function_decl));
+    util::TypeCacheStatistics statistics
+        = util::getTypeCacheStatistics(context);
+    EXPECT_EQ(3u, statistics.misses);
+    EXPECT_EQ(4u, statistics.hits);
+
+    // Checking the same functions again only hits the cache.
+    for (const clang::FunctionDecl *function_decl : function_decls)
+        EXPECT_FALSE(util::containsNonCopyableType(function_decl));
+    statistics = util::getTypeCacheStatistics(context);
+    EXPECT_EQ(3u, statistics.misses);
+    EXPECT_EQ(10u, statistics.hits);
+
+    util::clearTypeCaches(context);
+    statistics = util::getTypeCacheStatistics(context);
+    EXPECT_EQ(0u, statistics.misses);
+    EXPECT_EQ(0u, statistics.hits);
+}
+
+//==============================================================================
+TEST(Util, PartitionByCostBalancesCosts)
+{
+    // The most expensive items are placed first, each in the cheapest
+    // partition so far.
+    const std::vector<std::size_t> costs{4, 8, 5, 7, 6};
+    const auto partitions = util::partitionByCost(costs, 2);
+    EXPECT_EQ((std::vector<std::vector<std::size_t>>{{0, 1, 2}, {3, 4}}),
+              partitions);
+
+    // The partitions differ in cost by less than the largest item.
+    std::vector<std::size_t> partition_costs;
+    for (const auto &partition : partitions)
+    {
+        std::size_t cost = 0;
+        for (const std::size_t index : partition)
+            cost += costs[index];
+        partition_costs.push_back(cost);
+    }
+    EXPECT_EQ((std::vector<std::size_t>{17, 13}), partition_costs);
+}
+
+//==============================================================================
+TEST(Util, PartitionByCostSpreadsEqualCosts)
+{
+    EXPECT_EQ((std::vector<std::vector<std::size_t>>{
+                  {0, 3, 6, 9}, {1, 4, 7}, {2, 5, 8}}),
+              util::partitionByCost(std::vector<std::size_t>(10, 1), 3));
+
+    // Items without cost do not leave partitions empty.
+    EXPECT_EQ((std::vector<std::vector<std::size_t>>{{0}, {1}, {2}}),
+              util::partitionByCost({0, 0, 0}, 3));
+
+    // There are never more partitions than items.
+    EXPECT_EQ((std::vector<std::vector<std::size_t>>{{1}, {0}}),
+              util::partitionByCost({3, 5}, 5));
+    EXPECT_TRUE(util::partitionByCost({}, 4).empty());
+}